@@ -0,0 +1,265 @@
+#pragma once
+
+#include "trace.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Состояние подключения приложения. Колбэки MQTT-клиента и основной цикл не пишут его,
+// а передают события; переход берётся из таблицы и применяется атомарно (compare-and-swap),
+// поэтому событие, устаревшее к моменту применения, не затирает более новое состояние:
+// например, повтор подключения после только что пришедшего onConnect игнорируется.
+enum class AppState : uint8_t {
+    WaitingToConnect,
+    Connected,
+    Disconnected,
+    Reconnecting,
+    Restarting,
+    // Перезапуск, во время которого соединение разорвалось: по его окончании - Disconnected
+    RestartingDisconnected,
+    Exiting
+};
+
+enum class AppEvent : uint8_t {
+    // Основной цикл запустил подключение в фоне
+    ConnectStarted,
+    // Клиент подключился (поток MQTT)
+    ConnectSucceeded,
+    // Подключение разорвано (поток MQTT) или не удалось (основной цикл)
+    ConnectionLost,
+    // Подошло время следующей попытки подключения
+    RetryDue,
+    RetriesExhausted,
+    RestartRequested,
+    // Перезапуск завершён с сохранённым соединением / без соединения
+    RestartedOnline,
+    RestartedOffline
+};
+
+inline constexpr std::size_t app_state_count = 7;
+inline constexpr std::size_t app_event_count = 8;
+
+using AppTransitionTable = std::array<std::array<AppState, app_event_count>, app_state_count>;
+
+// Строка - состояние, столбец - событие. Переход в то же состояние - событие игнорируется.
+inline constexpr AppTransitionTable app_transitions = [] {
+    using S = AppState;
+    using E = AppEvent;
+    AppTransitionTable table{};
+    for (std::size_t state = 0; state < app_state_count; ++state) {
+        table[state].fill(static_cast<S>(state));
+    }
+    auto set = [&table](S from, E event, S to) {
+        table[static_cast<std::size_t>(from)][static_cast<std::size_t>(event)] = to;
+    };
+
+    set(S::WaitingToConnect, E::ConnectSucceeded, S::Connected);
+    set(S::WaitingToConnect, E::ConnectionLost, S::Disconnected);
+    set(S::WaitingToConnect, E::RestartRequested, S::Restarting);
+
+    set(S::Connected, E::ConnectionLost, S::Disconnected);
+    set(S::Connected, E::RestartRequested, S::Restarting);
+
+    // Подключение, завершившееся после отказа предыдущей попытки, всё равно принимается
+    set(S::Disconnected, E::ConnectSucceeded, S::Connected);
+    set(S::Disconnected, E::RetryDue, S::Reconnecting);
+    set(S::Disconnected, E::RetriesExhausted, S::Exiting);
+    set(S::Disconnected, E::RestartRequested, S::Restarting);
+
+    // Разрыв прежнего соединения уже не важен: новое вот-вот начнётся
+    set(S::Reconnecting, E::ConnectStarted, S::WaitingToConnect);
+    set(S::Reconnecting, E::ConnectSucceeded, S::Connected);
+    set(S::Reconnecting, E::RestartRequested, S::Restarting);
+
+    // События соединения не отменяют запрошенный перезапуск. Разрыв запоминается до его
+    // окончания: тёплый перезапуск сообщает RestartedOnline по данным клиента, которые
+    // могли устареть
+    set(S::Restarting, E::ConnectionLost, S::RestartingDisconnected);
+    set(S::Restarting, E::RestartedOnline, S::Connected);
+    set(S::Restarting, E::RestartedOffline, S::Disconnected);
+
+    set(S::RestartingDisconnected, E::ConnectSucceeded, S::Restarting);
+    set(S::RestartingDisconnected, E::RestartedOnline, S::Disconnected);
+    set(S::RestartingDisconnected, E::RestartedOffline, S::Disconnected);
+
+    return table;
+}();
+
+constexpr AppState appTransition(AppState state, AppEvent event)
+{
+    return app_transitions[static_cast<std::size_t>(state)][static_cast<std::size_t>(event)];
+}
+
+constexpr bool appExitingIsTerminal()
+{
+    for (std::size_t event = 0; event < app_event_count; ++event) {
+        if (appTransition(AppState::Exiting, static_cast<AppEvent>(event)) != AppState::Exiting) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Из состояния from последовательностью событий достижимо to
+constexpr bool appReachable(AppState from, AppState to)
+{
+    std::array<bool, app_state_count> seen{};
+    seen[static_cast<std::size_t>(from)] = true;
+    for (bool grown = true; grown;) {
+        grown = false;
+        for (std::size_t state = 0; state < app_state_count; ++state) {
+            for (std::size_t event = 0; seen[state] && event < app_event_count; ++event) {
+                const auto next = static_cast<std::size_t>(
+                    appTransition(static_cast<AppState>(state), static_cast<AppEvent>(event)));
+                grown = grown || !seen[next];
+                seen[next] = true;
+            }
+        }
+    }
+    return seen[static_cast<std::size_t>(to)];
+}
+
+constexpr bool appStatesReachableAndCanExit()
+{
+    for (std::size_t state = 0; state < app_state_count; ++state) {
+        const auto s = static_cast<AppState>(state);
+        if (!appReachable(AppState::WaitingToConnect, s) || !appReachable(s, AppState::Exiting)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(appExitingIsTerminal());
+static_assert(appStatesReachableAndCanExit());
+// Гонка «повтор подключения затирает Connected» невозможна по построению
+static_assert(appTransition(AppState::Connected, AppEvent::RetryDue) == AppState::Connected);
+static_assert(appTransition(AppState::Connected, AppEvent::ConnectStarted) == AppState::Connected);
+static_assert(appTransition(AppState::Restarting, AppEvent::ConnectSucceeded)
+              == AppState::Restarting);
+static_assert(appTransition(AppState::Restarting, AppEvent::ConnectionLost)
+              == AppState::RestartingDisconnected);
+// Разрыв во время перезапуска не теряется
+static_assert(appTransition(AppState::RestartingDisconnected, AppEvent::RestartedOnline)
+              == AppState::Disconnected);
+
+// Автомат по таблице app_transitions без блокировок: состояние и счётчики входов в каждое
+// состояние - одно атомарное слово, поэтому снимок никогда не показывает новое состояние
+// без его входа. post() потокобезопасен; действия при входе в состояние (сброс счётчиков
+// попыток и т.п.) выполняет основной цикл через AppStateObserver.
+class AppStateMachine
+{
+public:
+    // Согласованный снимок слова автомата
+    class Snapshot
+    {
+    public:
+        AppState state() const { return stateOf(word_); }
+        // Число входов в состояние по модулю 2^entry_bits
+        uint64_t entries(AppState state) const
+        {
+            return word_ >> shiftOf(state) & entry_mask;
+        }
+
+        bool operator==(const Snapshot &) const = default;
+
+    private:
+        friend class AppStateMachine;
+
+        explicit Snapshot(uint64_t word)
+            : word_(word)
+        {}
+
+        uint64_t word_;
+    };
+
+    static constexpr int entry_bits = 8;
+    static constexpr uint64_t entry_mask = (uint64_t{1} << entry_bits) - 1;
+
+    explicit AppStateMachine(AppState initial)
+        : word_(static_cast<uint64_t>(initial))
+    {}
+
+    AppStateMachine(const AppStateMachine &) = delete;
+    AppStateMachine &operator=(const AppStateMachine &) = delete;
+
+    // false - событие в текущем состоянии игнорируется
+    bool post(AppEvent event)
+    {
+        uint64_t word = word_.load(std::memory_order_acquire);
+        uint64_t next_word;
+        do {
+            const auto next = appTransition(stateOf(word), event);
+            if (next == stateOf(word)) {
+                return false;
+            }
+            const auto shift = shiftOf(next);
+            const auto entries = ((word >> shift) + 1) & entry_mask;
+            next_word = (word & ~(entry_mask << shift) & ~state_mask) | entries << shift
+                        | static_cast<uint64_t>(next);
+        } while (!word_.compare_exchange_weak(
+            word, next_word, std::memory_order_acq_rel, std::memory_order_acquire));
+        changed_ns_.store(trace::nowNs(), std::memory_order_release);
+        return true;
+    }
+
+    Snapshot snapshot() const { return Snapshot(word_.load(std::memory_order_acquire)); }
+    AppState state() const { return snapshot().state(); }
+    // Время последнего перехода по trace::nowNs(), для измерения задержки реакции на него
+    int64_t changedNs() const { return changed_ns_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr int state_bits = 8;
+    static constexpr uint64_t state_mask = (uint64_t{1} << state_bits) - 1;
+    static_assert(state_bits + entry_bits * app_state_count <= 64);
+
+    static AppState stateOf(uint64_t word) { return static_cast<AppState>(word & state_mask); }
+
+    static int shiftOf(AppState state)
+    {
+        return state_bits + entry_bits * static_cast<int>(state);
+    }
+
+    std::atomic<uint64_t> word_;
+    std::atomic<int64_t> changed_ns_{0};
+};
+
+// Входы в состояния, накопленные по снимкам автомата. Снимки берутся хотя бы раз
+// на 2^entry_bits входов в одно состояние: основной цикл делает это каждую итерацию,
+// а каждый вход в Connected требует нового соединения.
+class AppStateObserver
+{
+public:
+    explicit AppStateObserver(const AppStateMachine::Snapshot &initial)
+        : seen_(initial)
+    {}
+
+    // false - с прошлого снимка переходов не было
+    bool update(const AppStateMachine::Snapshot &snapshot)
+    {
+        if (snapshot == seen_) {
+            entered_.fill(0);
+            return false;
+        }
+        for (std::size_t state = 0; state < app_state_count; ++state) {
+            const auto s = static_cast<AppState>(state);
+            entered_[state] = (snapshot.entries(s) - seen_.entries(s))
+                              & AppStateMachine::entry_mask;
+            entries_[state] += entered_[state];
+        }
+        seen_ = snapshot;
+        return true;
+    }
+
+    // Входы в состояние между двумя последними снимками
+    uint64_t entered(AppState state) const { return entered_[static_cast<std::size_t>(state)]; }
+    // Все замеченные входы в состояние
+    uint64_t entries(AppState state) const { return entries_[static_cast<std::size_t>(state)]; }
+
+private:
+    AppStateMachine::Snapshot seen_;
+    std::array<uint64_t, app_state_count> entered_{};
+    std::array<uint64_t, app_state_count> entries_{};
+};
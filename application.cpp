@@ -1,78 +1,449 @@
 #include "application.hpp"
-#include <iostream>
-#include <nlohmann/json.hpp>
-#include <thread>
+#include "base64.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// "embedded/pins/<n>/set" -> n
+std::optional<int> pinFromSetTopic(std::string_view topic)
+{
+    static constexpr std::string_view prefix = "embedded/pins/";
+    static constexpr std::string_view suffix = "/set";
+
+    if (topic.size() <= prefix.size() + suffix.size() || topic.substr(0, prefix.size()) != prefix
+        || topic.substr(topic.size() - suffix.size()) != suffix) {
+        return std::nullopt;
+    }
+
+    std::string_view number = topic.substr(prefix.size(),
+                                           topic.size() - prefix.size() - suffix.size());
+    int pin = 0;
+    auto [end, ec] = std::from_chars(number.data(), number.data() + number.size(), pin);
+    if (ec != std::errc() || end != number.data() + number.size()) {
+        return std::nullopt;
+    }
+    return pin;
+}
+
+constexpr auto int_min = std::numeric_limits<int>::min();
+constexpr auto int_max = std::numeric_limits<int>::max();
+
+bool fitsInt(const Json &value)
+{
+    if (value.is_number_unsigned()) {
+        return value.get<uint64_t>() <= static_cast<uint64_t>(int_max);
+    }
+    return value.is_number_integer() && value.get<int64_t>() >= int_min
+           && value.get<int64_t>() <= int_max;
+}
+
+// Целое JSON с насыщением до границ int. Простое приведение берёт младшие 32 бита,
+// и 4294967309 превращается в 13, проходя проверку диапазона.
+int saturatedInt(const Json &value)
+{
+    if (fitsInt(value)) {
+        return value.get<int>();
+    }
+    return value.is_number_unsigned() || value.get<int64_t>() > 0 ? int_max : int_min;
+}
+
+// Проверка полей red/green/blue, при ошибке возвращает её код
+std::optional<ErrorCode> parseRgb(const Json &data, control::Rgb &rgb)
+{
+    static constexpr int color_min = 0;
+    static constexpr int color_max = 255;
+
+    // Проверка наличия и типа
+    if (!data.contains("red") || !data.contains("green") || !data.contains("blue")
+        || !data["red"].is_number_integer() || !data["green"].is_number_integer()
+        || !data["blue"].is_number_integer()) {
+        return ErrorCode::InvalidRgbFields;
+    }
+
+    int red = saturatedInt(data["red"]);
+    int green = saturatedInt(data["green"]);
+    int blue = saturatedInt(data["blue"]);
+
+    if (red < color_min || red > color_max || green < color_min || green > color_max
+        || blue < color_min || blue > color_max) {
+        return ErrorCode::RgbOutOfRange;
+    }
+
+    rgb = {static_cast<uint8_t>(red), static_cast<uint8_t>(green), static_cast<uint8_t>(blue)};
+    return std::nullopt;
+}
+
+// Роль пина в конфигурации и его тип/режим
+struct PinRole
+{
+    int PinConfig::*pin;
+    gpio::PinType type;
+    gpio::PinMode mode;
+};
+
+constexpr PinRole pin_roles[] = {
+    {&PinConfig::red_pin, gpio::PinType::Analog, gpio::PinMode::Output},
+    {&PinConfig::green_pin, gpio::PinType::Analog, gpio::PinMode::Output},
+    {&PinConfig::blue_pin, gpio::PinType::Analog, gpio::PinMode::Output},
+    {&PinConfig::temperature_pin, gpio::PinType::Analog, gpio::PinMode::Input},
+    {&PinConfig::button_pin, gpio::PinType::Digital, gpio::PinMode::Input},
+    {&PinConfig::led_pin, gpio::PinType::Digital, gpio::PinMode::Output},
+};
+
+std::optional<gpio::Easing> parseEasing(const std::string &name)
+{
+    if (name == "linear") {
+        return gpio::Easing::Linear;
+    }
+    if (name == "ease_in") {
+        return gpio::Easing::EaseIn;
+    }
+    if (name == "ease_out") {
+        return gpio::Easing::EaseOut;
+    }
+    if (name == "ease_in_out") {
+        return gpio::Easing::EaseInOut;
+    }
+    return std::nullopt;
+}
+
+// Проверка полей команды без выполнения, name - значение поля "command"
+std::optional<ErrorCode> parseCommand(const Json &data,
+                                      const std::string &name,
+                                      control::Command &command)
+{
+    static constexpr int max_fade_duration_ms = 60000;
+
+    if (name == "restart") {
+        auto mode = control::RestartMode::Cold;
+        if (data.contains("mode")) {
+            if (data["mode"] == "warm") {
+                mode = control::RestartMode::Warm;
+            } else if (data["mode"] != "cold") {
+                return ErrorCode::InvalidRestartMode;
+            }
+        }
+        command = control::Restart{mode};
+        return std::nullopt;
+    }
+
+    if (name == "set_rgb") {
+        control::Rgb rgb{};
+        if (auto error = parseRgb(data, rgb)) {
+            return error;
+        }
+        command = control::SetRgb{rgb};
+        return std::nullopt;
+    }
+
+    if (name == "fade_rgb") {
+        control::Rgb rgb{};
+        if (auto error = parseRgb(data, rgb)) {
+            return error;
+        }
+
+        if (!data.contains("duration_ms") || !data["duration_ms"].is_number_integer()) {
+            return ErrorCode::InvalidDuration;
+        }
+
+        int duration_ms = saturatedInt(data["duration_ms"]);
+        if (duration_ms < 0 || duration_ms > max_fade_duration_ms) {
+            return ErrorCode::DurationOutOfRange;
+        }
+
+        std::optional<gpio::Easing> easing = gpio::Easing::Linear;
+        if (data.contains("easing")) {
+            easing = data["easing"].is_string() ? parseEasing(data["easing"]) : std::nullopt;
+            if (!easing) {
+                return ErrorCode::InvalidEasing;
+            }
+        }
+
+        command = control::FadeRgb{rgb, duration_ms, *easing};
+        return std::nullopt;
+    }
+
+    if (name == "set_pin") {
+        // Номер пина не насыщается: иначе 2^63 совпал бы с пином int_max из конфигурации
+        if (!data.contains("pin") || !fitsInt(data["pin"])) {
+            return ErrorCode::InvalidPinField;
+        }
+        if (!data.contains("value") || !data["value"].is_number_integer()) {
+            return ErrorCode::InvalidPinValue;
+        }
+        command = control::SetPin{data["pin"].get<int>(), saturatedInt(data["value"])};
+        return std::nullopt;
+    }
+
+    return ErrorCode::UnsupportedCommand;
+}
+
+constexpr std::size_t max_batch_commands = 32;
+
+// {"command": "batch", "mode": "atomic" | "sequential", "commands": [...]} или просто массив
+// команд (atomic). Ошибки отдельных команд записываются в их элементы.
+std::optional<ErrorCode> parseBatch(const Json &data,
+                                    control::BatchMode &mode,
+                                    std::vector<control::BatchItem> &items)
+{
+    mode = control::BatchMode::Atomic;
+    const Json *commands = &data;
+    if (!data.is_array()) {
+        if (data.contains("mode")) {
+            if (data["mode"] == "sequential") {
+                mode = control::BatchMode::Sequential;
+            } else if (data["mode"] != "atomic") {
+                return ErrorCode::InvalidBatch;
+            }
+        }
+        if (!data.contains("commands")) {
+            return ErrorCode::InvalidBatch;
+        }
+        commands = &data["commands"];
+    }
+
+    if (!commands->is_array() || commands->empty() || commands->size() > max_batch_commands) {
+        return ErrorCode::InvalidBatch;
+    }
+
+    items.resize(commands->size());
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const Json &entry = (*commands)[i];
+        auto &item = items[i];
+        if (!entry.is_object() || !entry.contains("command") || !entry["command"].is_string()) {
+            item.error = ErrorCode::InvalidCommandField;
+            continue;
+        }
+        item.name = entry["command"].get<std::string>();
+        if (item.name == "batch") {
+            item.error = ErrorCode::InvalidBatch;
+            item.detail = "nested batch";
+            continue;
+        }
+        item.error = parseCommand(entry, item.name, item.command);
+        if (item.error == ErrorCode::UnsupportedCommand) {
+            item.detail = item.name;
+        }
+    }
+    return std::nullopt;
+}
+
+// Периодическая публикация: строка, а не литерал, чтобы не выделять временную
+const std::string temperature_topic = "embedded/sensors/temperature";
+
+// Ограничения входящего потока команд
+constexpr std::size_t max_pending_events = 256;
+constexpr double topic_rate_per_s = 50.0;
+constexpr double topic_burst = 100.0;
+constexpr double command_rate_per_s = 20.0;
+constexpr double command_burst = 40.0;
+constexpr auto error_report_window = std::chrono::milliseconds(1000);
+// Хватает на запрос истории с максимальным ответом (16 блоков в base64)
+constexpr std::size_t loop_arena_size = 64 * 1024;
+// Строки сообщения в слоте очереди под типичную команду; более длинное сообщение
+// выделяет память один раз, и она остаётся в слоте
+constexpr std::size_t reserved_topic_size = 64;
+constexpr std::size_t reserved_payload_size = 256;
+constexpr std::size_t reserved_property_size = 64;
+// Максимальное ожидание события; задаёт шаг проверки таймеров
+constexpr auto loop_wait = std::chrono::milliseconds(10);
+// Первая попытка переподключения после разрыва или неудачного старта
+constexpr auto initial_retry_delay = std::chrono::milliseconds(100);
+// Период перезаписи файла состояния (признак живости)
+constexpr auto status_period = std::chrono::seconds(1);
+
+} // namespace
 
 Application::Application(const AppConfig &config,
                          std::unique_ptr<mqtt::IClient> mqtt_client,
                          std::unique_ptr<gpio::IManager> gpio_manager,
-                         std::unique_ptr<TemperatureSensor> temperature_sensor)
+                         std::unique_ptr<TemperatureSensor> temperature_sensor,
+                         std::unique_ptr<timeseries::Store> history,
+                         std::unique_ptr<journal::PinJournal> pin_journal,
+                         std::shared_ptr<IClock> clock)
     : config_(config)
     , mqtt_client_(std::move(mqtt_client))
     , gpio_manager_(std::move(gpio_manager))
     , temperature_sensor_(std::move(temperature_sensor))
+    , history_(std::move(history))
+    , pin_journal_(std::move(pin_journal))
+    , clock_(clock ? std::move(clock) : std::make_shared<SystemClock>())
+    , events_(max_pending_events)
+    , arena_(loop_arena_size)
+    , unknown_command_limit_(command_rate_per_s, command_burst, clock_->now())
+    , error_reporter_(
+          error_report_window,
+          [this](const std::string &summary) {
+              mqtt::PublishOptions options;
+              options.priority = mqtt::Priority::High;
+              mqtt_client_->publish("embedded/errors", summary, options);
+          },
+          clock_->now())
+    , pin_state_(
+          std::chrono::milliseconds(config.pin_snapshot_period_ms),
+          [this](const std::string &topic, const std::string &payload, bool retain) {
+              // Дельты теряются при переполнении полосы, подписчик увидит разрыв номеров;
+              // из снимков в очереди остаётся только последний
+              mqtt::PublishOptions options;
+              options.retain = retain;
+              options.priority = mqtt::Priority::Telemetry;
+              options.latest_only = retain;
+              mqtt_client_->publish(topic, payload, options);
+          },
+          [this](std::vector<gpio::PinSnapshot> &pins) { gpio_manager_->snapshotInto(pins); },
+          clock_->now())
     , state_(State::WaitingToConnect)
+    , restart_mode_(RestartMode::Cold)
     , reconnect_attempts_(0)
     , led_state_(false)
-    , last_reconnect_time_(std::chrono::steady_clock::now())
+    , last_reconnect_time_(clock_->now())
+    , state_observer_(state_.snapshot())
+    , last_temperature_time_(clock_->now())
+    , last_config_poll_time_(clock_->now())
+    , retry_delay_(initial_retry_delay)
+    , started_(clock_->now())
 {
+    if (!config_.config_file.empty()) {
+        config_watcher_.emplace(config_.config_file);
+        if (auto content = config_watcher_->readIfChanged()) {
+            try {
+                config_ = applyConfigJson(config_, *content);
+            } catch (const std::exception &e) {
+                printError("[APP] Ignoring configuration file " + config_.config_file + ": "
+                           + e.what());
+            }
+        }
+        pin_state_.setSnapshotPeriod(std::chrono::milliseconds(config_.pin_snapshot_period_ms));
+    }
+
+    if (!config_.status_file.empty()) {
+        status_file_.emplace(config_.status_file);
+    }
+
+    for (const char *command : {"restart", "set_rgb", "fade_rgb", "set_pin", "batch"}) {
+        command_limits_.emplace(command,
+                                TokenBucket(command_rate_per_s, command_burst, clock_->now()));
+    }
+
+    // Все слоты очереди и текущее событие - один круг буферов
+    events_.prepareSlots([](Event &slot) { reserveMessage(std::get<IncomingMessage>(slot)); });
+    reserveMessage(std::get<IncomingMessage>(event_));
+
     setupGpioPins();
+    restoreOutputs();
     setupGpioHandlers();
 }
 
 Application::~Application() = default;
 
+void Application::reserveMessage(IncomingMessage &message)
+{
+    message.topic.reserve(reserved_topic_size);
+    message.payload.reserve(reserved_payload_size);
+    message.response_topic.reserve(reserved_property_size);
+    message.correlation_data.reserve(reserved_property_size);
+}
+
 void Application::setupGpioPins()
 {
-    gpio_manager_->registerPin({config_.pins.red_pin, gpio::PinType::Analog, gpio::PinMode::Output});
-    gpio_manager_->registerPin(
-        {config_.pins.green_pin, gpio::PinType::Analog, gpio::PinMode::Output});
-    gpio_manager_->registerPin(
-        {config_.pins.blue_pin, gpio::PinType::Analog, gpio::PinMode::Output});
-    gpio_manager_->registerPin(
-        {config_.pins.temperature_pin, gpio::PinType::Analog, gpio::PinMode::Input});
-    gpio_manager_->registerPin(
-        {config_.pins.button_pin, gpio::PinType::Digital, gpio::PinMode::Input});
-    gpio_manager_->registerPin(
-        {config_.pins.led_pin, gpio::PinType::Digital, gpio::PinMode::Output});
+    for (const auto &role : pin_roles) {
+        gpio_manager_->registerPin({config_.pins.*role.pin, role.type, role.mode});
+    }
+}
+
+// До установки колбэков: восстановленные значения не пишутся в журнал повторно и не
+// публикуются дельтами - подписчики получат их снимком после подключения
+void Application::restoreOutputs()
+{
+    if (!pin_journal_) {
+        return;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    int restored = 0;
+    for (const auto &[pin, value] : pin_journal_->state()) {
+        // Значения пинов, которые по текущей конфигурации не выходы, пропускаются
+        for (const auto &role : pin_roles) {
+            if (config_.pins.*role.pin != pin || role.mode != gpio::PinMode::Output) {
+                continue;
+            }
+            try {
+                if (role.type == gpio::PinType::Analog) {
+                    gpio_manager_->writeAnalogPin(pin, value);
+                } else {
+                    gpio_manager_->writeDigitalPin(pin,
+                                                   value ? gpio::DigitalValue::High
+                                                         : gpio::DigitalValue::Low);
+                    if (pin == config_.pins.led_pin) {
+                        led_state_ = value != 0;
+                    }
+                }
+                ++restored;
+            } catch (const std::exception &e) {
+                printError("[APP] Failed to restore pin " + std::to_string(pin) + ": "
+                           + e.what());
+            }
+            break;
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started);
+    printMessage(
+        "[APP] Restored ", restored, " output(s) from journal in ", elapsed.count(), " us");
 }
 
 void Application::removeGpioPins()
 {
-    gpio_manager_->unregisterPin(config_.pins.red_pin);
-    gpio_manager_->unregisterPin(config_.pins.green_pin);
-    gpio_manager_->unregisterPin(config_.pins.blue_pin);
-    gpio_manager_->unregisterPin(config_.pins.temperature_pin);
-    gpio_manager_->unregisterPin(config_.pins.button_pin);
-    gpio_manager_->unregisterPin(config_.pins.led_pin);
+    for (const auto &role : pin_roles) {
+        gpio_manager_->unregisterPin(config_.pins.*role.pin);
+    }
 }
 
 void Application::setupGpioHandlers()
 {
     gpio_manager_->setWriteDigitalCallback([this](int pin, gpio::DigitalValue value) {
-        printMessage("[APP] Digital pin " + std::to_string(pin) + " changed to "
-                     + (value == gpio::DigitalValue::High ? "HIGH" : "LOW"));
-
-        nlohmann::json message;
-        message["pin"] = pin;
-        message["value"] = value;
-        std::string payload = message.dump();
-
-        printMessage("[APP] Publishing MQTT message to topic 'embedded/pins/state': " + payload);
-        mqtt_client_->publish("embedded/pins/state", payload);
+        printMessage("[APP] Digital pin ",
+                     pin,
+                     " changed to ",
+                     value == gpio::DigitalValue::High ? "HIGH" : "LOW");
+        const uint8_t level = value == gpio::DigitalValue::High ? 1 : 0;
+        recordHistory(timeseries::pinSeries(pin), level);
+        if (pin_journal_) {
+            pin_journal_->record(pin, level);
+        }
+        pin_state_.change(pin, level);
     });
 
     gpio_manager_->setWriteAnalogCallback([this](int pin, uint8_t value) {
-        printMessage("[APP] Analog pin " + std::to_string(pin) + " set to " + std::to_string(value));
+        printMessage("[APP] Analog pin ", pin, " set to ", static_cast<int>(value));
+        recordHistory(timeseries::pinSeries(pin), value);
+        if (pin_journal_) {
+            pin_journal_->record(pin, value);
+        }
+        pin_state_.change(pin, value);
+    });
 
-        nlohmann::json message;
-        message["pin"] = pin;
-        message["value"] = value;
-        std::string payload = message.dump();
+    setupButtonHandler();
+}
 
-        printMessage("[APP] Publishing MQTT message to topic 'embedded/pins/state': " + payload);
-        mqtt_client_->publish("embedded/pins/state", payload);
-    });
+void Application::setupButtonHandler()
+{
+    // Кнопка не опрашивается: основной цикл будится только на реальных нажатиях
+    gpio_manager_->setEdgeCallback(config_.pins.button_pin,
+                                   gpio::EdgeMode::Rising,
+                                   std::chrono::milliseconds(config_.button_debounce_ms),
+                                   [this](int, gpio::DigitalValue) {
+                                       if (!events_.tryPush(ButtonPressed{})) {
+                                           ++dropped_messages_;
+                                       }
+                                   });
 }
 
 void Application::removeGpioHandlers()
@@ -83,155 +454,783 @@ void Application::removeGpioHandlers()
 
 void Application::setupMqttHandlers()
 {
-    mqtt_client_->setMessageCallback([this](const std::string &topic, const std::string &payload) {
-        incoming_messages_.emplace(topic, payload);
-    });
-
     mqtt_client_->setConnectCallback([this]() {
         printMessage("[APP] MQTT Client Connected");
-        {
-            std::lock_guard<std::mutex> lock(state_mutex_);
-            state_ = State::Connected;
-            reconnect_attempts_ = 0;
-        }
+        // Сохранённый снимок у брокера мог устареть за время разрыва
+        pin_state_.requestSnapshot();
+        postStateEvent(AppEvent::ConnectSucceeded);
     });
 
     mqtt_client_->setDisconnectCallback([this](int reason) {
-        printMessage("[APP] MQTT Client Disconnected, reason = " + std::to_string(reason));
-        {
-            std::lock_guard<std::mutex> lock(state_mutex_);
-            if (state_ != State::Restarting) {
-                state_ = State::Disconnected;
-                last_reconnect_time_ = std::chrono::steady_clock::now();
+        printMessage("[APP] MQTT Client Disconnected, reason = ", reason);
+        postStateEvent(AppEvent::ConnectionLost);
+    });
+}
+
+void Application::postStateEvent(AppEvent event)
+{
+    // Очередь полна - цикл и так не спит и увидит переход на следующей итерации
+    if (state_.post(event)) {
+        events_.tryPush(StateChanged{});
+    }
+}
+
+void Application::subscribeTopics()
+{
+    // Допуск выполняется ещё в потоке mosquitto, до копирования в очередь:
+    // у каждой подписки свой лимит частоты, очередь ограничена по размеру
+    auto enqueue = [this](MessageHandler handler) {
+        TokenBucket limit(topic_rate_per_s, topic_burst, clock_->now());
+        return [this, handler, limit](const std::string &topic,
+                                      const std::string &payload,
+                                      const mqtt::MessageProperties &properties) mutable {
+            if (!limit.tryConsume(clock_->now())) {
+                ++rate_limited_messages_;
+                return;
             }
+            // Заполнение на месте: строки слота уже имеют буферы от прошлых сообщений
+            const bool queued = events_.tryPushWith([&](Event &slot) {
+                auto *message = std::get_if<IncomingMessage>(&slot);
+                if (!message) {
+                    // Слот занимало событие кнопки или автомата, буферы создаются заново
+                    message = &slot.emplace<IncomingMessage>();
+                    reserveMessage(*message);
+                }
+                message->topic.assign(topic);
+                message->payload.assign(payload);
+                message->handler = handler;
+                message->response_topic.assign(properties.response_topic);
+                message->correlation_data.assign(properties.correlation_data);
+                message->trace_id = trace::currentId();
+                message->enqueued_ns = message->trace_id ? trace::nowNs() : 0;
+            });
+            if (!queued) {
+                ++dropped_messages_;
+            }
+        };
+    };
+
+    // Клиент сам восстанавливает подписки после каждого переподключения
+    mqtt_client_->subscribeRequests("embedded/control",
+                                    enqueue(&Application::processIncomingMessage));
+    mqtt_client_->subscribeRequests("embedded/pins/+/set",
+                                    enqueue(&Application::processPinCommand));
+    mqtt_client_->subscribeRequests("embedded/config",
+                                    enqueue(&Application::processConfigMessage));
+    mqtt_client_->subscribeRequests("embedded/history/query",
+                                    enqueue(&Application::processHistoryQuery));
+}
+
+void Application::connectToMqtt()
+{
+    // Разрешение имени и TCP-соединение блокируют на время до таймаута сети:
+    // основной цикл в это время продолжает обслуживать GPIO и датчик
+    connecting_ = std::async(std::launch::async, [this] {
+        if (mqtt_client_->isConnected()) {
+            mqtt_client_->disconnect();
         }
+        mqtt_client_->connect();
     });
 }
 
-void Application::connectToMqtt()
+void Application::pollConnect()
 {
+    if (!connecting_.valid()
+        || connecting_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+
     try {
-        mqtt_client_->connect();
-        mqtt_client_->subscribe("embedded/control");
-        {
-            std::lock_guard<std::mutex> lock(state_mutex_);
-            state_ = State::WaitingToConnect;
-        }
+        connecting_.get();
     } catch (const std::exception &e) {
-        printError("[APP] MQTT initial client connect failed: " + std::string(e.what()));
-        {
-            std::lock_guard<std::mutex> lock(state_mutex_);
-            state_ = State::Disconnected;
-            last_reconnect_time_ = std::chrono::steady_clock::now();
-        }
+        printError("[APP] MQTT connect failed: " + std::string(e.what()));
+        state_.post(AppEvent::ConnectionLost);
     }
 }
 
+Application::State Application::observeState(IClock::TimePoint now)
+{
+    const auto snapshot = state_.snapshot();
+    if (!state_observer_.update(snapshot)) {
+        return snapshot.state();
+    }
+    // От события до реакции основного цикла. Переход - не команда: без идентификатора трассы,
+    // чтобы не попасть в command.total
+    trace::record("app.transition", 0, state_.changedNs(), trace::nowNs());
+
+    if (state_observer_.entered(State::Connected) != 0) {
+        reconnect_attempts_ = 0;
+        retry_delay_ = initial_retry_delay;
+    }
+    if (state_observer_.entered(State::Disconnected) != 0) {
+        last_reconnect_time_ = now;
+    }
+    return snapshot.state();
+}
+
 void Application::processIncomingMessage(const std::string &topic, const std::string &payload)
 {
-    printMessage("[APP] MQTT message received: [" + topic + "] " + payload);
+    printMessage("[APP] MQTT message received: [", topic, "] ", payload);
 
-    nlohmann::json data;
+    JsonDocument data;
     try {
-        data = nlohmann::json::parse(payload);
+        trace::Scope span("command.parse");
+        data = parseJson(payload);
     } catch (const std::exception &e) {
-        mqtt_client_->publish("embedded/errors", "Invalid JSON format: " + std::string(e.what()));
+        reportError(ErrorCode::InvalidJson, e.what());
+        return;
+    }
+
+    const bool is_batch = data.is_array()
+                          || (data.contains("command") && data["command"] == "batch");
+    if (is_batch) {
+        if (!admitCommand("batch")) {
+            return;
+        }
+
+        control::BatchMode mode;
+        std::vector<control::BatchItem> items;
+        if (auto error = parseBatch(data, mode, items)) {
+            reportError(*error);
+            JsonDocument result;
+            result["status"] = "error";
+            result["code"] = static_cast<int>(*error);
+            result["message"] = errorMessage(*error);
+            publishBatchResult(json_writer_.write(result), false);
+            return;
+        }
+        processBatch(mode, items);
         return;
     }
 
     if (!data.contains("command") || !data["command"].is_string()) {
-        mqtt_client_->publish("embedded/errors", "Missing or invalid 'command' field");
+        reportError(ErrorCode::InvalidCommandField);
         return;
     }
 
-    const std::string command = data["command"];
+    const std::string name = data["command"];
+
+    if (!admitCommand(name)) {
+        return;
+    }
 
-    if (topic == "embedded/control" && command == "restart") {
-        printMessage("[APP] Received restart command");
-        {
-            std::lock_guard<std::mutex> lock(state_mutex_);
-            state_ = State::Restarting;
+    control::Command command;
+    auto error = parseCommand(data, name, command);
+    if (!error) {
+        if (auto *pin = std::get_if<control::SetPin>(&command)) {
+            error = checkPinCommand(*pin);
         }
+    }
+    if (error) {
+        reportError(*error, *error == ErrorCode::UnsupportedCommand ? name : std::string());
         return;
     }
 
-    if (topic == "embedded/control" && command == "set_rgb") {
-        static constexpr int color_min = 0;
-        static constexpr int color_max = 255;
+    try {
+        executeCommand(command);
+    } catch (const std::exception &e) {
+        reportError(ErrorCode::GpioFailure, e.what());
+    }
+}
 
-        // Проверка наличия и типа
-        if (!data.contains("red") || !data.contains("green") || !data.contains("blue")
-            || !data["red"].is_number_integer() || !data["green"].is_number_integer()
-            || !data["blue"].is_number_integer()) {
-            mqtt_client_->publish("embedded/errors",
-                                  "Missing or invalid 'red', 'green', or 'blue' fields");
-            return;
+void Application::processPinCommand(const std::string &topic, const std::string &payload)
+{
+    printMessage("[APP] MQTT message received: [", topic, "] ", payload);
+
+    auto pin = pinFromSetTopic(topic);
+    if (!pin) {
+        reportError(ErrorCode::InvalidPinTopic, topic);
+        return;
+    }
+
+    JsonDocument data;
+    try {
+        trace::Scope span("command.parse");
+        data = parseJson(payload);
+    } catch (const std::exception &e) {
+        reportError(ErrorCode::InvalidJson, e.what());
+        return;
+    }
+
+    if (!data.contains("value") || !data["value"].is_number_integer()) {
+        reportError(ErrorCode::InvalidPinValue);
+        return;
+    }
+
+    const control::SetPin command{*pin, saturatedInt(data["value"])};
+    if (auto error = checkPinCommand(command)) {
+        reportError(*error, *error == ErrorCode::PinNotControllable ? topic : std::string());
+        return;
+    }
+
+    try {
+        executeCommand(command);
+    } catch (const std::exception &e) {
+        reportError(ErrorCode::GpioFailure, e.what());
+    }
+}
+
+void Application::processBatch(control::BatchMode mode, std::vector<control::BatchItem> &items)
+{
+    const bool atomic = mode == control::BatchMode::Atomic;
+
+    // Допуск и проверки, зависящие от конфигурации - до первой записи в GPIO
+    bool all_valid = true;
+    for (auto &item : items) {
+        if (!item.error) {
+            if (!admitCommand(item.name)) {
+                item.rate_limited = true;
+                all_valid = false;
+                continue;
+            }
+            if (auto *pin = std::get_if<control::SetPin>(&item.command)) {
+                item.error = checkPinCommand(*pin);
+                if (item.error == ErrorCode::PinNotControllable) {
+                    item.detail = "pin " + std::to_string(pin->pin);
+                }
+            }
         }
+        if (item.error) {
+            reportError(*item.error, item.detail);
+            all_valid = false;
+        }
+    }
 
-        int red = data["red"];
-        int green = data["green"];
-        int blue = data["blue"];
+    printMessage("[APP] Received ",
+                 atomic ? "atomic" : "sequential",
+                 " batch of ",
+                 items.size(),
+                 " command(s)");
 
-        if (red < color_min || red > color_max || green < color_min || green > color_max
-            || blue < color_min || blue > color_max) {
-            mqtt_client_->publish("embedded/errors", "RGB values must be in range [0, 255]");
-            return;
+    bool failed = false;
+    if (!atomic || all_valid) {
+        // Состояние выходов до пачки, чтобы откатить атомарную пачку при сбое GPIO
+        std::vector<gpio::PinSnapshot> before;
+        const bool saved_led_state = led_state_;
+        if (atomic) {
+            before = gpio_manager_->snapshot();
         }
 
-        printMessage("[APP] Received RGB command: R=" + std::to_string(red)
-                     + " G=" + std::to_string(green) + " B=" + std::to_string(blue));
+        for (auto &item : items) {
+            if (item.error || item.rate_limited) {
+                continue;
+            }
+            try {
+                executeCommand(item.command);
+                item.executed = true;
+            } catch (const std::exception &e) {
+                item.error = ErrorCode::GpioFailure;
+                reportError(ErrorCode::GpioFailure, e.what());
+                failed = true;
+                if (atomic) {
+                    break;
+                }
+            }
+        }
+
+        if (failed && atomic) {
+            printError("[APP] Batch failed, restoring outputs");
+            for (const auto &pin : before) {
+                if (pin.mode != gpio::PinMode::Output) {
+                    continue;
+                }
+                try {
+                    if (pin.type == gpio::PinType::Analog) {
+                        gpio_manager_->writeAnalogPin(pin.number, pin.value);
+                    } else {
+                        gpio_manager_->writeDigitalPin(pin.number,
+                                                       pin.value ? gpio::DigitalValue::High
+                                                                 : gpio::DigitalValue::Low);
+                    }
+                } catch (const std::exception &e) {
+                    printError("[APP] Failed to restore pin " + std::to_string(pin.number)
+                               + ": " + e.what());
+                }
+            }
+            led_state_ = saved_led_state;
+            for (auto &item : items) {
+                item.executed = false;
+            }
+        }
+    }
+
+    std::size_t executed = 0;
+    JsonDocument result;
+    Json &results = result["results"];
+    results = Json::array();
+    for (const auto &item : items) {
+        Json entry;
+        if (item.executed) {
+            entry["status"] = "ok";
+            ++executed;
+        } else if (item.rate_limited) {
+            entry["status"] = "rate_limited";
+        } else if (item.error) {
+            entry["status"] = "error";
+            entry["code"] = static_cast<int>(*item.error);
+            entry["message"] = errorMessage(*item.error);
+        } else {
+            // Не выполнена из-за ошибки другой команды атомарной пачки
+            entry["status"] = "skipped";
+        }
+        results.push_back(std::move(entry));
+    }
+
+    const bool ok = executed == items.size();
+    result["status"] = ok ? "ok" : "error";
+    result["mode"] = atomic ? "atomic" : "sequential";
+    result["executed"] = executed;
+    publishBatchResult(json_writer_.write(result), ok);
+}
+
+void Application::publishBatchResult(const std::string &payload, bool ok)
+{
+    // Изменения пинов пачки ставятся в очередь до результата. При очереди телеметрии
+    // результат из полосы High их обгоняет.
+    pin_state_.flush(clock_->now());
+    // Запросу MQTT 5 результат уходит ответом, иначе - в общий топик
+    if (reply_) {
+        sendReply(payload, ok ? "ok" : "error");
+    } else {
+        mqtt::PublishOptions options;
+        options.priority = mqtt::Priority::High;
+        mqtt_client_->publish("embedded/control/result", payload, options);
+    }
+}
+
+void Application::executeCommand(const control::Command &command)
+{
+    if (const auto *restart = std::get_if<control::Restart>(&command)) {
+        printMessage("[APP] Received ",
+                     restart->mode == RestartMode::Warm ? "warm" : "cold",
+                     " restart command");
+        // Повторная команда до начала перезапуска не меняет его режим
+        if (state_.post(AppEvent::RestartRequested)) {
+            restart_mode_ = restart->mode;
+        }
+        return;
+    }
 
+    if (const auto *set = std::get_if<control::SetRgb>(&command)) {
+        const auto &rgb = set->rgb;
+        printMessage("[APP] Received RGB command: R=",
+                     static_cast<int>(rgb.red),
+                     " G=",
+                     static_cast<int>(rgb.green),
+                     " B=",
+                     static_cast<int>(rgb.blue));
+
+        trace::Scope span("gpio.write");
+        gpio_manager_->writeAnalogPin(config_.pins.red_pin, rgb.red);
+        gpio_manager_->writeAnalogPin(config_.pins.green_pin, rgb.green);
+        gpio_manager_->writeAnalogPin(config_.pins.blue_pin, rgb.blue);
+        return;
+    }
+
+    if (const auto *fade = std::get_if<control::FadeRgb>(&command)) {
+        const auto &rgb = fade->rgb;
+        printMessage("[APP] Received RGB fade command: R=",
+                     static_cast<int>(rgb.red),
+                     " G=",
+                     static_cast<int>(rgb.green),
+                     " B=",
+                     static_cast<int>(rgb.blue),
+                     " in ",
+                     fade->duration_ms,
+                     " ms");
+
+        // Публикуются только начальное состояние (здесь) и конечное (колбэк записи пина),
+        // промежуточные шаги выполняются внутри gpio::Manager без обращения к брокеру
+        const std::pair<int, uint8_t> targets[] = {{config_.pins.red_pin, rgb.red},
+                                                   {config_.pins.green_pin, rgb.green},
+                                                   {config_.pins.blue_pin, rgb.blue}};
+        for (const auto &[pin, target] : targets) {
+            JsonDocument message;
+            message["pin"] = pin;
+            message["value"] = gpio_manager_->readAnalogPin(pin);
+            message["target"] = target;
+            message["duration_ms"] = fade->duration_ms;
+            mqtt::PublishOptions options;
+            options.priority = mqtt::Priority::Telemetry;
+            mqtt_client_->publish(PinStateSync::delta_topic, json_writer_.write(message), options);
+
+            gpio_manager_->fadeAnalogPin(pin,
+                                         target,
+                                         std::chrono::milliseconds(fade->duration_ms),
+                                         fade->easing);
+        }
+        return;
+    }
+
+    const auto &set_pin = std::get<control::SetPin>(command);
+    trace::Scope span("gpio.write");
+    if (set_pin.pin == config_.pins.led_pin) {
+        led_state_ = set_pin.value == 1;
+        gpio_manager_->writeDigitalPin(set_pin.pin,
+                                       led_state_ ? gpio::DigitalValue::High
+                                                  : gpio::DigitalValue::Low);
+    } else {
+        gpio_manager_->writeAnalogPin(set_pin.pin, static_cast<uint8_t>(set_pin.value));
+    }
+}
+
+std::optional<ErrorCode> Application::checkPinCommand(const control::SetPin &command) const
+{
+    if (command.pin == config_.pins.led_pin) {
+        if (command.value != 0 && command.value != 1) {
+            return ErrorCode::DigitalValueOutOfRange;
+        }
+        return std::nullopt;
+    }
+    if (command.pin == config_.pins.red_pin || command.pin == config_.pins.green_pin
+        || command.pin == config_.pins.blue_pin) {
+        if (command.value < 0 || command.value > 255) {
+            return ErrorCode::AnalogValueOutOfRange;
+        }
+        return std::nullopt;
+    }
+    return ErrorCode::PinNotControllable;
+}
+
+void Application::processConfigMessage(const std::string &topic, const std::string &payload)
+{
+    printMessage("[APP] MQTT message received: [", topic, "] ", payload);
+
+    try {
+        applyConfig(applyConfigJson(config_, payload));
+    } catch (const std::exception &e) {
+        reportError(ErrorCode::InvalidConfig, e.what());
+    }
+}
+
+void Application::processHistoryQuery(const std::string &topic, const std::string &payload)
+{
+    // Не больше блоков в одном ответе (~1.3 КБ JSON на блок), остальное - повторным запросом
+    static constexpr std::size_t max_history_blocks = 16;
+
+    printMessage("[APP] MQTT message received: [", topic, "] ", payload);
+
+    if (!history_) {
+        reportError(ErrorCode::HistoryUnavailable);
+        return;
+    }
+
+    JsonDocument data;
+    try {
+        data = parseJson(payload);
+    } catch (const std::exception &e) {
+        reportError(ErrorCode::InvalidJson, e.what());
+        return;
+    }
+
+    // "temperature" или "pin/<n>"
+    std::optional<timeseries::SeriesId> series;
+    if (data.contains("series") && data["series"].is_string()) {
+        const std::string name = data["series"];
+        if (name == "temperature") {
+            series = timeseries::temperature_series;
+        } else if (name.starts_with("pin/")) {
+            int pin = 0;
+            auto [end, ec] = std::from_chars(name.data() + 4, name.data() + name.size(), pin);
+            if (ec == std::errc() && end == name.data() + name.size() && pin >= 0) {
+                series = timeseries::pinSeries(pin);
+            }
+        }
+    }
+
+    if (!series || (data.contains("from_ms") && !data["from_ms"].is_number_integer())
+        || (data.contains("to_ms") && !data["to_ms"].is_number_integer())) {
+        reportError(ErrorCode::InvalidHistoryQuery, payload);
+        return;
+    }
+
+    // Границы по умолчанию - вся сохранённая история
+    const int64_t from_ms = data.value("from_ms", int64_t{0});
+    const int64_t to_ms = data.value("to_ms", std::numeric_limits<int64_t>::max());
+
+    auto blocks = history_->query(*series, from_ms, to_ms, max_history_blocks + 1);
+
+    JsonDocument response;
+    response["series"] = data["series"];
+    response["from_ms"] = from_ms;
+    response["to_ms"] = to_ms;
+    response["truncated"] = blocks.size() > max_history_blocks;
+    response["blocks"] = Json::array();
+    for (std::size_t i = 0; i < blocks.size() && i < max_history_blocks; ++i) {
+        const auto &block = blocks[i];
+        Json entry;
+        entry["start_ms"] = block.start_ms;
+        entry["end_ms"] = block.end_ms;
+        entry["count"] = block.count;
+        entry["bits"] = block.bit_length;
+        entry["data"] = base64Encode(block.data.data(), block.data.size());
+        response["blocks"].push_back(std::move(entry));
+    }
+    if (reply_) {
+        sendReply(json_writer_.write(response), "ok");
+    } else {
+        mqtt_client_->publish("embedded/history/blocks", json_writer_.write(response));
+    }
+}
+
+void Application::pollConfigFile()
+{
+    static constexpr auto config_poll_interval = std::chrono::seconds(1);
+
+    auto now = clock_->now();
+    if (!config_watcher_ || now - last_config_poll_time_ < config_poll_interval) {
+        return;
+    }
+    last_config_poll_time_ = now;
+
+    if (auto content = config_watcher_->readIfChanged()) {
+        printMessage("[APP] Configuration file changed: ", config_.config_file);
         try {
-            gpio_manager_->writeAnalogPin(config_.pins.red_pin, static_cast<uint8_t>(red));
-            gpio_manager_->writeAnalogPin(config_.pins.green_pin, static_cast<uint8_t>(green));
-            gpio_manager_->writeAnalogPin(config_.pins.blue_pin, static_cast<uint8_t>(blue));
+            applyConfig(applyConfigJson(config_, *content));
         } catch (const std::exception &e) {
-            mqtt_client_->publish("embedded/errors", "GPIO error: " + std::string(e.what()));
+            printError("[APP] Invalid configuration file: " + std::string(e.what()));
+            reportError(ErrorCode::InvalidConfig, e.what());
         }
+    }
+}
 
+void Application::applyConfig(const AppConfig &new_config)
+{
+    auto started = std::chrono::steady_clock::now();
+
+    // Переназначаются только пины, номер которых изменился. Сначала снимаются все старые,
+    // чтобы поддержать обмен номерами между ролями, выходы сохраняют своё значение.
+    struct Moved
+    {
+        const PinRole *role;
+        int old_pin;
+        int new_pin;
+        uint8_t value;
+    };
+    std::vector<Moved> moved;
+    for (const auto &role : pin_roles) {
+        int old_pin = config_.pins.*role.pin;
+        int new_pin = new_config.pins.*role.pin;
+        if (old_pin == new_pin) {
+            continue;
+        }
+
+        uint8_t value = 0;
+        if (role.mode == gpio::PinMode::Output) {
+            value = role.type == gpio::PinType::Analog
+                        ? gpio_manager_->readAnalogPin(old_pin)
+                        : gpio_manager_->readDigitalPin(old_pin) == gpio::DigitalValue::High;
+        }
+        moved.push_back({&role, old_pin, new_pin, value});
+    }
+
+    for (const auto &pin : moved) {
+        gpio_manager_->unregisterPin(pin.old_pin);
+    }
+    for (const auto &pin : moved) {
+        gpio_manager_->registerPin({pin.new_pin, pin.role->type, pin.role->mode});
+    }
+
+    const bool button_changed = config_.pins.button_pin != new_config.pins.button_pin
+                                || config_.button_debounce_ms != new_config.button_debounce_ms;
+
+    // Периоды (температура, переподключение) читаются из config_ на каждой итерации цикла,
+    // поэтому новое значение начинает действовать с ближайшей проверки таймера
+    config_ = new_config;
+
+    for (const auto &pin : moved) {
+        if (pin.role->mode != gpio::PinMode::Output) {
+            continue;
+        }
+        if (pin.role->type == gpio::PinType::Analog) {
+            gpio_manager_->writeAnalogPin(pin.new_pin, pin.value);
+        } else {
+            gpio_manager_->writeDigitalPin(pin.new_pin,
+                                           pin.value ? gpio::DigitalValue::High
+                                                     : gpio::DigitalValue::Low);
+        }
+    }
+
+    if (button_changed) {
+        setupButtonHandler();
+    }
+
+    pin_state_.setSnapshotPeriod(std::chrono::milliseconds(config_.pin_snapshot_period_ms));
+    // Номера пинов в сохранённом снимке устарели
+    if (!moved.empty()) {
+        pin_state_.requestSnapshot();
+    }
+
+    auto blackout = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started);
+    printMessage("[APP] Configuration applied in ",
+                 blackout.count(),
+                 " us, ",
+                 moved.size(),
+                 " pin(s) re-registered");
+
+    mqtt_client_->publish("embedded/config/state", configToJson(config_));
+}
+
+bool Application::admitCommand(const std::string &command)
+{
+    auto it = command_limits_.find(command);
+    auto &limit = it != command_limits_.end() ? it->second : unknown_command_limit_;
+    if (!limit.tryConsume(clock_->now())) {
+        ++rate_limited_messages_;
+        return false;
+    }
+    return true;
+}
+
+void Application::recordHistory(timeseries::SeriesId series, double value)
+{
+    if (!history_) {
         return;
     }
+    // История хранится с метками реального времени, чтобы её можно было сопоставить снаружи
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        clock_->wallNow().time_since_epoch());
+    try {
+        history_->append(series, now.count(), value);
+    } catch (const std::exception &e) {
+        // Вызывается и из колбэков GPIO: ошибка истории не должна ломать запись пина
+        printError("[APP] History append failed: " + std::string(e.what()));
+    }
+}
+
+void Application::reportError(ErrorCode code, std::string_view detail)
+{
+    error_reporter_.report(code, detail, clock_->now());
+    if (reply_ && !reply_->error) {
+        reply_->error = code;
+    }
+}
+
+void Application::sendReply(const std::string &payload, std::string_view status)
+{
+    // Параметры ответа переиспользуются: строки сохраняют буферы между запросами
+    auto &options = reply_options_;
+    options.correlation_data.assign(reply_->request->correlation_data);
+    options.user_properties.clear();
+    options.user_properties.emplace_back("status", status);
+    options.priority = mqtt::Priority::High;
+    mqtt_client_->publish(reply_->request->response_topic, payload, options);
+    reply_->sent = true;
+}
+
+void Application::dispatchMessage(const IncomingMessage &message)
+{
+    trace::Context trace_context(message.trace_id);
+    if (message.trace_id) {
+        trace::record("event.queue", message.trace_id, message.enqueued_ns, trace::nowNs());
+    }
+    trace::Scope span("command.dispatch");
 
-    // Неизвестная команда или топик
-    mqtt_client_->publish("embedded/errors", "Unsupported command or topic: " + command);
+    if (!message.response_topic.empty()) {
+        reply_.emplace(PendingReply{&message, std::nullopt, false});
+    }
+
+    (this->*message.handler)(message.topic, message.payload);
+    // Изменения пинов команды уходят до ответа на неё
+    pin_state_.flush(clock_->now());
+
+    if (reply_ && !reply_->sent) {
+        const char *result = reply_->error ? "error" : "ok";
+        JsonDocument status;
+        status["status"] = result;
+        if (reply_->error) {
+            status["code"] = static_cast<int>(*reply_->error);
+            status["message"] = errorMessage(*reply_->error);
+        }
+        sendReply(json_writer_.write(status), result);
+    }
+    reply_.reset();
+}
+
+void Application::flushErrors()
+{
+    error_reporter_.addDropped(rate_limited_messages_.exchange(0), dropped_messages_.exchange(0));
+    error_reporter_.flush(clock_->now());
 }
 
 void Application::processButton()
 {
-    auto button_state = gpio_manager_->readDigitalPin(config_.pins.button_pin);
-    if (button_state == gpio::DigitalValue::High) {
-        led_state_ = !led_state_;
-        gpio_manager_->writeDigitalPin(config_.pins.led_pin,
-                                       led_state_ ? gpio::DigitalValue::High
-                                                  : gpio::DigitalValue::Low);
+    led_state_ = !led_state_;
+    gpio_manager_->writeDigitalPin(config_.pins.led_pin,
+                                   led_state_ ? gpio::DigitalValue::High : gpio::DigitalValue::Low);
+}
+
+void Application::warmRestart()
+{
+    auto started = std::chrono::steady_clock::now();
+
+    // Подписки и сессия остаются в mqtt::Client, соединение не трогаем.
+    // Значения пинов восстанавливаются до установки колбэков, поэтому не публикуются повторно.
+    auto pins = gpio_manager_->snapshot();
+
+    removeGpioHandlers();
+    removeGpioPins();
+    setupGpioPins();
+
+    for (const auto &pin : pins) {
+        try {
+            if (pin.type == gpio::PinType::Analog) {
+                if (pin.mode == gpio::PinMode::Output) {
+                    gpio_manager_->writeAnalogPin(pin.number, pin.value);
+                } else {
+                    gpio_manager_->injectAnalogValue(pin.number, pin.value);
+                }
+            } else {
+                auto value = pin.value ? gpio::DigitalValue::High : gpio::DigitalValue::Low;
+                if (pin.mode == gpio::PinMode::Output) {
+                    gpio_manager_->writeDigitalPin(pin.number, value);
+                } else {
+                    gpio_manager_->injectDigitalValue(pin.number, value);
+                }
+            }
+        } catch (const std::exception &e) {
+            printError("[APP] Failed to restore pin " + std::to_string(pin.number) + ": "
+                       + e.what());
+        }
     }
+
+    setupGpioHandlers();
+
+    state_.post(mqtt_client_->isConnected() ? AppEvent::RestartedOnline
+                                            : AppEvent::RestartedOffline);
+    reconnect_attempts_ = 0;
+    last_reconnect_time_ = clock_->now();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started);
+    printMessage("[APP] Warm restart completed in ", elapsed.count(), " us");
 }
 
 void Application::restart()
 {
     static constexpr int restart_timeout_s = 3;
 
+    if (connecting_.valid()) {
+        connecting_.wait();
+    }
     mqtt_client_->disconnect();
     removeGpioPins();
     removeGpioHandlers();
 
-    {
-        std::lock_guard<std::mutex> lock(state_mutex_);
-        state_ = State::Disconnected;
-    }
+    state_.post(AppEvent::RestartedOffline);
 
     printMessage("[APP] Restarting...");
-    std::this_thread::sleep_for(std::chrono::seconds(restart_timeout_s));
+    clock_->sleepFor(std::chrono::seconds(restart_timeout_s));
 
     // конфигурируем заново gpio
     setupGpioPins();
+    restoreOutputs();
     setupGpioHandlers();
 }
 
-void Application::processTemperatureSensor()
+void Application::processTemperatureSensor(bool publish)
 {
-    static constexpr auto temperature_publish_timeout_s = 5;
-
     static constexpr struct AnalogRange
     {
         int Min = 0;
@@ -244,16 +1243,24 @@ void Application::processTemperatureSensor()
         int Max = 300;
     } temperature_range;
 
-    static auto last_temp_time = std::chrono::steady_clock::now();
+    auto now = clock_->now();
 
-    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_temperature_time_).count()
+        >= config_.temperature_period_ms) {
+        last_temperature_time_ = now;
 
-    if (std::chrono::duration_cast<std::chrono::seconds>(now - last_temp_time).count()
-        >= temperature_publish_timeout_s) {
-        int temperature = temperature_sensor_->getTemperatureTenthCelsius();
+        auto sample = temperature_sensor_->tryGetTemperatureTenthCelsius();
+        if (!sample) {
+            reportError(ErrorCode::SensorDropout);
+            return;
+        }
+        int temperature = *sample;
 
-        uint8_t analog = (temperature - temperature_range.Min) * analog_range.Max
-                         / (temperature_range.Max - temperature_range.Min);
+        // Модели датчика могут выходить за диапазон (выбросы), АЦП насыщается
+        uint8_t analog = std::clamp((temperature - temperature_range.Min) * analog_range.Max
+                                        / (temperature_range.Max - temperature_range.Min),
+                                    analog_range.Min,
+                                    analog_range.Max);
 
         gpio_manager_->injectAnalogValue(config_.pins.temperature_pin, analog);
 
@@ -261,95 +1268,129 @@ void Application::processTemperatureSensor()
         temperature = raw * (temperature_range.Max - temperature_range.Min) / analog_range.Max
                       + temperature_range.Min;
 
-        std::string payload = "{\"temperature\":" + std::to_string(temperature) + "}";
-        mqtt_client_->publish("embedded/sensors/temperature", payload);
+        recordHistory(timeseries::temperature_series, temperature);
+        if (!publish) {
+            return;
+        }
+
+        JsonDocument message;
+        message["temperature"] = temperature;
+        const auto &payload = json_writer_.write(message);
+        mqtt::PublishOptions options;
+        options.priority = mqtt::Priority::Telemetry;
+        options.latest_only = true;
+        mqtt_client_->publish(temperature_topic, payload, options);
+
+        printMessage("[APP] Published temperature: ", payload);
+    }
+}
 
-        printMessage("[APP] Published temperature: " + payload);
-        last_temp_time = now;
+bool Application::waitForEvent(std::chrono::milliseconds timeout)
+{
+    if (clock_->isRealTime()) {
+        return events_.popInto(event_, static_cast<int>(timeout.count()));
+    }
+
+    // Симулированное время двигает только основной цикл: нет событий - сдвигаем часы
+    if (events_.tryPopInto(event_)) {
+        return true;
     }
+    clock_->sleepFor(timeout);
+    return false;
 }
 
 void Application::run()
 {
     setupMqttHandlers();
+    subscribeTopics();
     connectToMqtt();
 
-    constexpr int reconnect_interval_ms = 2000;
-
     bool is_running = true;
 
     while (is_running) {
-        State current_state;
-        {
-            std::lock_guard<std::mutex> lock(state_mutex_);
-            current_state = state_;
+        // Всё, что выделено из арены, живёт не дольше итерации
+        if (arena_.overflows() != seen_arena_overflows_) {
+            seen_arena_overflows_ = arena_.overflows();
+            printError("[APP] Loop arena exhausted, heap fallbacks so far: ",
+                       seen_arena_overflows_);
         }
+        arena_.reset();
+        ArenaScope arena_scope(arena_);
+
+        pollConnect();
+
+        auto now = clock_->now();
+        const State current_state = observeState(now);
 
-        auto now = std::chrono::steady_clock::now();
+        pollConfigFile();
+        flushErrors();
+        writeStatus(current_state, now);
 
         switch (current_state) {
         case State::WaitingToConnect:
+            serviceLocal(false);
             break;
 
         case State::Connected: {
-            processButton();
-            processTemperatureSensor();
-
-            if (auto msg = incoming_messages_.pop(0)) {
-                const auto &[topic, payload] = *msg;
-                processIncomingMessage(topic, payload);
+            // Изменения от кнопки и плавных переходов
+            pin_state_.flush(now);
+            if (!startup_time_) {
+                // Первая публикация после подключения - снимок пинов, запрошенный в onConnect
+                startup_time_ = std::chrono::duration_cast<std::chrono::milliseconds>(now
+                                                                                      - started_);
+                printMessage("[APP] First publish ", startup_time_->count(), " ms after start");
             }
+            serviceLocal(true);
             break;
         }
 
         case State::Disconnected: {
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_reconnect_time_)
-                    .count()
-                >= reconnect_interval_ms) {
-                {
-                    std::lock_guard<std::mutex> lock(state_mutex_);                 
-                    if (reconnect_attempts_ < config_.max_reconnect_attempts) {
-                        printMessage("[APP] Attempting reconnect MQTT connection, attempt "
-                                     + std::to_string(reconnect_attempts_ + 1));
-                        state_ = State::Reconnecting;
-                    } else {
-                        printError(
-                            "[APP] Max reconnection attempts reached, getting application to exit");
-                        last_reconnect_time_ = now;
-                        state_ = State::Exiting;
-                    }
+            const auto interval = std::chrono::milliseconds(config_.reconnect_interval_ms);
+            // Пока прежняя попытка не вернулась, новую не начинаем: её итог ещё может
+            // оказаться подключением
+            const bool retry_due = !connecting_.valid()
+                                   && now - last_reconnect_time_
+                                          >= std::min(retry_delay_, interval);
+            // Счётчики меняются, только если событие применилось: за время итерации
+            // могло прийти подключение
+            if (retry_due && retry_delay_ < interval) {
+                if (state_.post(AppEvent::RetryDue)) {
+                    printMessage("[APP] Attempting quick MQTT reconnect after ",
+                                 retry_delay_.count(),
+                                 " ms");
+                    retry_delay_ = std::min(retry_delay_ * 2, interval);
                 }
+            } else if (retry_due && reconnect_attempts_ < config_.max_reconnect_attempts) {
+                if (state_.post(AppEvent::RetryDue)) {
+                    printMessage("[APP] Attempting reconnect MQTT connection, attempt ",
+                                 reconnect_attempts_ + 1);
+                    ++reconnect_attempts_;
+                }
+            } else if (retry_due) {
+                if (state_.post(AppEvent::RetriesExhausted)) {
+                    printError(
+                        "[APP] Max reconnection attempts reached, getting application to exit");
+                }
+            } else {
+                serviceLocal(false);
             }
             break;
         }
 
         case State::Reconnecting: {
-            try {
-                if (mqtt_client_->isConnected()) {
-                    mqtt_client_->disconnect();
-                }
-                mqtt_client_->connect();
-                mqtt_client_->subscribe("embedded/control");
-                {
-                    std::lock_guard<std::mutex> lock(state_mutex_);
-                    state_ = state_ != State::Connected ? State::WaitingToConnect
-                                                        : State::Connected;
-                    reconnect_attempts_ = 0;
-                }
-            } catch (const std::exception &e) {
-                printError("[APP] Reconnect failed: " + std::string(e.what()));
-                {
-                    std::lock_guard<std::mutex> lock(state_mutex_);
-                    state_ = State::Disconnected;
-                    last_reconnect_time_ = now;
-                    reconnect_attempts_++;
-                }
+            if (state_.post(AppEvent::ConnectStarted)) {
+                connectToMqtt();
             }
             break;
         }
 
-        case State::Restarting: {
-            restart();
+        case State::Restarting:
+        case State::RestartingDisconnected: {
+            if (restart_mode_ == RestartMode::Warm) {
+                warmRestart();
+            } else {
+                restart();
+            }
             break;
         }
 
@@ -360,17 +1401,61 @@ void Application::run()
         }
         }
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
 }
 
-void Application::printMessage(const std::string &msg) const
+void Application::serviceLocal(bool connected)
 {
-    std::lock_guard<std::mutex> lock(log_mutex_);
-    std::cout << msg << std::endl;
+    processTemperatureSensor(connected);
+
+    if (waitForEvent(loop_wait)) {
+        if (auto *msg = std::get_if<IncomingMessage>(&event_)) {
+            dispatchMessage(*msg);
+        } else if (std::holds_alternative<ButtonPressed>(event_)) {
+            processButton();
+        }
+    }
+}
+
+void Application::writeStatus(State state, IClock::TimePoint now)
+{
+    const bool changed = state != status_state_;
+    if (!status_file_ || (!changed && now - last_status_time_ < status_period)) {
+        return;
+    }
+    status_state_ = state;
+    last_status_time_ = now;
+
+    JsonDocument status;
+    status["state"] = stateName(state);
+    status["ready"] = state == State::Connected;
+    status["uptime_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(now - started_)
+                              .count();
+    if (startup_time_) {
+        status["startup_ms"] = startup_time_->count();
+    }
+    status["arena_overflows"] = arena_.overflows();
+    if (!status_file_->write(json_writer_.write(status)) && changed) {
+        printError("[APP] Failed to write status file " + config_.status_file);
+    }
 }
 
-void Application::printError(const std::string &msg) const
+const char *Application::stateName(State state)
 {
-    std::lock_guard<std::mutex> lock(log_mutex_);
-    std::cerr << msg << std::endl;
+    switch (state) {
+    case State::WaitingToConnect:
+        return "waiting_to_connect";
+    case State::Connected:
+        return "connected";
+    case State::Disconnected:
+        return "disconnected";
+    case State::Reconnecting:
+        return "reconnecting";
+    case State::Restarting:
+        return "restarting";
+    case State::RestartingDisconnected:
+        return "restarting_disconnected";
+    case State::Exiting:
+        return "exiting";
+    }
+    return "unknown";
 }
@@ -1,15 +1,35 @@
 #pragma once
 
 #include "config.hpp"
+#include "app_state.hpp"
+#include "arena.hpp"
+#include "arena_json.hpp"
+#include "clock.hpp"
+#include "config_source.hpp"
+#include "control_command.hpp"
+#include "error_reporter.hpp"
 #include "gpio/gpio_imanager.hpp"
+#include "journal/pin_journal.hpp"
 #include "mqtt/mqtt_iclient.hpp"
+#include "pin_state_sync.hpp"
 #include "safe_queue.hpp"
+#include "status_file.hpp"
 #include "temperature_sensor.hpp"
+#include "timeseries/time_series_store.hpp"
+#include "token_bucket.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <future>
+#include <iostream>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
 
 class Application
 {
@@ -17,47 +37,186 @@ public:
     Application(const AppConfig &config,
                 std::unique_ptr<mqtt::IClient> mqtt_client,
                 std::unique_ptr<gpio::IManager> gpio_manager,
-                std::unique_ptr<TemperatureSensor> temperature_sensor);
+                std::unique_ptr<TemperatureSensor> temperature_sensor,
+                std::unique_ptr<timeseries::Store> history = nullptr,
+                std::unique_ptr<journal::PinJournal> pin_journal = nullptr,
+                std::shared_ptr<IClock> clock = nullptr);
     ~Application();
 
     void run();
     void restart();
+    void warmRestart();
 
 private:
-    enum class State {
-        WaitingToConnect,
-        Connected,
-        Disconnected,
-        Reconnecting,
-        Restarting,
-        Exiting
-    };
+    using State = AppState;
+
+    using RestartMode = control::RestartMode;
 
+    // Запускает подключение в фоне, итог забирает pollConnect()
     void connectToMqtt();
+    void pollConnect();
+    // Действия при входе в состояния, в которые автомат перешёл с прошлой итерации.
+    // Возвращает состояние того же снимка: по нему итерация и работает
+    State observeState(IClock::TimePoint now);
     void setupGpioPins();
+    void restoreOutputs();
     void removeGpioPins();
     void setupGpioHandlers();
+    void setupButtonHandler();
     void removeGpioHandlers();
     void setupMqttHandlers();
+    // Событие автомата из колбэка клиента; применённый переход будит основной цикл
+    void postStateEvent(AppEvent event);
+    void subscribeTopics();
     void processIncomingMessage(const std::string &topic, const std::string &payload);
+    void processPinCommand(const std::string &topic, const std::string &payload);
+    // Допуск, проверка, выполнение пачки команд и публикация общего результата
+    void processBatch(control::BatchMode mode, std::vector<control::BatchItem> &items);
+    void publishBatchResult(const std::string &payload, bool ok);
+    // Выполнение проверенной команды, исключения GPIO пробрасываются
+    void executeCommand(const control::Command &command);
+    std::optional<ErrorCode> checkPinCommand(const control::SetPin &command) const;
+    void processConfigMessage(const std::string &topic, const std::string &payload);
+    void processHistoryQuery(const std::string &topic, const std::string &payload);
     void processButton();
-    void processTemperatureSensor();
+    // publish = false - без соединения: значение только пишется в GPIO и историю
+    void processTemperatureSensor(bool publish);
+    // Датчик и события основного цикла; выполняется в любом состоянии соединения
+    void serviceLocal(bool connected);
+    void pollConfigFile();
+    void applyConfig(const AppConfig &new_config);
+    bool admitCommand(const std::string &command);
+    void recordHistory(timeseries::SeriesId series, double value);
+    void reportError(ErrorCode code, std::string_view detail = {});
+    void flushErrors();
+    // Ответ на запрос MQTT 5 в его response topic, status - значение user property "status"
+    void sendReply(const std::string &payload, std::string_view status);
+
+    void writeStatus(State state, IClock::TimePoint now);
+    static const char *stateName(State state);
 
-    void printMessage(const std::string &msg) const;
-    void printError(const std::string &msg) const;
+    // Части строки выводятся в поток по очереди, без сборки во временную строку
+    template<typename... Parts>
+    void printMessage(const Parts &...parts) const
+    {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        (std::cout << ... << parts) << std::endl;
+    }
+
+    template<typename... Parts>
+    void printError(const Parts &...parts) const
+    {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        (std::cerr << ... << parts) << std::endl;
+    }
 
 private:
+    // Обработчик выбирается маршрутизатором клиента в потоке mosquitto,
+    // а вызывается уже в основном цикле приложения
+    using MessageHandler = void (Application::*)(const std::string &topic,
+                                                 const std::string &payload);
+
+    struct IncomingMessage
+    {
+        std::string topic;
+        std::string payload;
+        MessageHandler handler;
+        // Заданы, если отправитель MQTT 5 ждёт ответ
+        std::string response_topic;
+        std::string correlation_data;
+        // Трасса команды (0 - не трассируется) и время постановки в очередь.
+        // Без инициализаторов по умолчанию: иначе variant внутри класса не считается
+        // конструируемым по умолчанию (слоты очереди создаются заранее)
+        uint64_t trace_id;
+        int64_t enqueued_ns;
+    };
+
+    // Ответ на обрабатываемый запрос: обработчик может ответить сам (sendReply),
+    // иначе после него отправляется статус - ok или первая ошибка обработки
+    struct PendingReply
+    {
+        // Обрабатываемое сообщение с response topic, живёт в event_ до конца обработки
+        const IncomingMessage *request;
+        std::optional<ErrorCode> error;
+        bool sent = false;
+    };
+
+    // Нажатие кнопки (передний фронт после антидребезга)
+    struct ButtonPressed
+    {};
+
+    // Переход автомата из потока MQTT: сам переход уже применён, событие только будит цикл
+    struct StateChanged
+    {};
+
+    // Все события основного цикла идут через одну очередь, чтобы цикл
+    // просыпался сразу по их приходу, а не опрашивал источники
+    using Event = std::variant<IncomingMessage, ButtonPressed, StateChanged>;
+
+    static void reserveMessage(IncomingMessage &message);
+    // Кладёт следующее событие в event_, false - событий не было
+    bool waitForEvent(std::chrono::milliseconds timeout);
+    void dispatchMessage(const IncomingMessage &message);
+
     AppConfig config_;
     std::unique_ptr<mqtt::IClient> mqtt_client_;
     std::unique_ptr<gpio::IManager> gpio_manager_;
     std::unique_ptr<TemperatureSensor> temperature_sensor_;
-    SafeQueue<std::pair<std::string, std::string>> incoming_messages_;
+    // История датчиков и выходов, nullptr - запись отключена
+    std::unique_ptr<timeseries::Store> history_;
+    // Журнал записей выходов для восстановления после перезапуска, nullptr - отключён
+    std::unique_ptr<journal::PinJournal> pin_journal_;
+    // Все таймеры основного цикла считаются по этим часам, nullptr в конструкторе - SystemClock
+    std::shared_ptr<IClock> clock_;
+    SafeQueue<Event> events_;
+    // Текущее событие: обменивается со слотом очереди, так что буферы строк
+    // сообщений ходят по кругу и не выделяются заново
+    Event event_;
+    // JSON команд и ответов одной итерации основного цикла
+    Arena arena_;
+    // Сколько раз арены не хватило, по данным прошлой итерации: рост пишется в лог
+    std::size_t seen_arena_overflows_ = 0;
 
-    State state_;
+    // Отброшенные до обработки сообщения, пишутся из потока mosquitto
+    std::atomic<uint64_t> rate_limited_messages_{0};
+    std::atomic<uint64_t> dropped_messages_{0};
+    // Лимиты на известные команды, все остальные делят один общий лимит
+    std::unordered_map<std::string, TokenBucket> command_limits_;
+    TokenBucket unknown_command_limit_;
+    ErrorReporter error_reporter_;
+    PinStateSync pin_state_;
+    std::optional<PendingReply> reply_;
+    mqtt::PublishOptions reply_options_;
+    // Сериализация исходящих сообщений основного цикла
+    JsonWriter json_writer_;
+
+    // Меняется только событиями, в том числе из потока MQTT
+    AppStateMachine state_;
+    // Остальное состояние подключения - только основного цикла
+    RestartMode restart_mode_;
     int reconnect_attempts_;
-    std::chrono::steady_clock::time_point last_reconnect_time_;
+    IClock::TimePoint last_reconnect_time_;
+    // Входы в состояния, которые основной цикл уже обработал
+    AppStateObserver state_observer_;
+    IClock::TimePoint last_temperature_time_;
     bool led_state_;
 
-    mutable std::mutex state_mutex_;
+    std::optional<ConfigFileWatcher> config_watcher_;
+    IClock::TimePoint last_config_poll_time_;
+
+    // Задержка следующей попытки подключения: после разрыва растёт вдвое от короткой
+    // до reconnect_interval_ms, короткие попытки не считаются в max_reconnect_attempts
+    std::chrono::milliseconds retry_delay_;
+    IClock::TimePoint started_;
+    // От создания приложения до первой публикации после подключения
+    std::optional<std::chrono::milliseconds> startup_time_;
+    std::optional<StatusFile> status_file_;
+    std::optional<State> status_state_;
+    IClock::TimePoint last_status_time_;
+
     mutable std::mutex log_mutex_;
+
+    // Последним, чтобы разрушаться первым: деструктор ждёт конца подключения,
+    // которое обращается к остальным полям
+    std::future<void> connecting_;
 };
@@ -0,0 +1,427 @@
+#include "arena_json.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+
+// Команды вложены на 2-3 уровня; ограничение защищает стек рекурсивного разбора
+constexpr int max_depth = 64;
+
+class Parser
+{
+public:
+    explicit Parser(std::string_view text)
+        : text_(text)
+    {}
+
+    void parseDocument(Json &out)
+    {
+        parseValue(out, 0);
+        skipWhitespace();
+        if (pos_ != text_.size()) {
+            fail("unexpected data after value");
+        }
+    }
+
+private:
+    [[noreturn]] void fail(const char *what) const
+    {
+        throw std::runtime_error("JSON parse error at offset " + std::to_string(pos_) + ": "
+                                 + what);
+    }
+
+    bool atEnd() const { return pos_ == text_.size(); }
+
+    unsigned char current() const { return static_cast<unsigned char>(text_[pos_]); }
+
+    bool isDigit() const { return !atEnd() && current() >= '0' && current() <= '9'; }
+
+    void skipDigits()
+    {
+        while (isDigit()) {
+            ++pos_;
+        }
+    }
+
+    void skipWhitespace()
+    {
+        while (!atEnd()
+               && (current() == ' ' || current() == '\t' || current() == '\n'
+                   || current() == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char c)
+    {
+        if (atEnd() || text_[pos_] != c) {
+            return false;
+        }
+        ++pos_;
+        return true;
+    }
+
+    void expectLiteral(std::string_view literal)
+    {
+        if (text_.substr(pos_, literal.size()) != literal) {
+            fail("invalid literal");
+        }
+        pos_ += literal.size();
+    }
+
+    void parseValue(Json &out, int depth)
+    {
+        skipWhitespace();
+        if (atEnd()) {
+            fail("unexpected end of input");
+        }
+        switch (current()) {
+        case '{':
+            parseObject(out, depth + 1);
+            return;
+        case '[':
+            parseArray(out, depth + 1);
+            return;
+        case '"':
+            out = Json(Json::value_t::string);
+            parseString(*out.get_ptr<Json::string_t *>());
+            return;
+        case 't':
+            expectLiteral("true");
+            out = true;
+            return;
+        case 'f':
+            expectLiteral("false");
+            out = false;
+            return;
+        case 'n':
+            expectLiteral("null");
+            out = nullptr;
+            return;
+        default:
+            parseNumber(out);
+            return;
+        }
+    }
+
+    void parseObject(Json &out, int depth)
+    {
+        if (depth > max_depth) {
+            fail("nesting too deep");
+        }
+        ++pos_;
+        out = Json(Json::value_t::object);
+        auto &object = *out.get_ptr<Json::object_t *>();
+        skipWhitespace();
+        if (consume('}')) {
+            return;
+        }
+
+        std::string key;
+        do {
+            skipWhitespace();
+            if (atEnd() || current() != '"') {
+                fail("expected string key");
+            }
+            key.clear();
+            parseString(key);
+            skipWhitespace();
+            if (!consume(':')) {
+                fail("expected ':'");
+            }
+            // Повторный ключ заменяет значение, как в nlohmann
+            parseValue(object[key], depth);
+            skipWhitespace();
+        } while (consume(','));
+
+        if (!consume('}')) {
+            fail("expected ',' or '}'");
+        }
+    }
+
+    void parseArray(Json &out, int depth)
+    {
+        if (depth > max_depth) {
+            fail("nesting too deep");
+        }
+        ++pos_;
+        out = Json(Json::value_t::array);
+        auto &array = *out.get_ptr<Json::array_t *>();
+        skipWhitespace();
+        if (consume(']')) {
+            return;
+        }
+
+        do {
+            parseValue(array.emplace_back(), depth);
+            skipWhitespace();
+        } while (consume(','));
+
+        if (!consume(']')) {
+            fail("expected ',' or ']'");
+        }
+    }
+
+    void parseString(std::string &out)
+    {
+        ++pos_;
+        while (true) {
+            // Обычные символы копируются отрезками
+            const std::size_t start = pos_;
+            while (!atEnd() && current() >= 0x20 && current() < 0x80 && current() != '"'
+                   && current() != '\\') {
+                ++pos_;
+            }
+            out.append(text_, start, pos_ - start);
+
+            if (atEnd()) {
+                fail("unterminated string");
+            }
+            if (current() == '"') {
+                ++pos_;
+                return;
+            }
+            if (current() == '\\') {
+                parseEscape(out);
+            } else if (current() < 0x20) {
+                fail("control character in string");
+            } else {
+                appendUtf8(out);
+            }
+        }
+    }
+
+    // Многобайтовая последовательность UTF-8 по RFC 3629: без избыточных форм
+    // и суррогатов
+    void appendUtf8(std::string &out)
+    {
+        const unsigned char lead = current();
+        std::size_t continuation = 0;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            continuation = 1;
+        } else if (lead == 0xE0) {
+            continuation = 2;
+            low = 0xA0;
+        } else if (lead == 0xED) {
+            continuation = 2;
+            high = 0x9F;
+        } else if (lead >= 0xE1 && lead <= 0xEF) {
+            continuation = 2;
+        } else if (lead == 0xF0) {
+            continuation = 3;
+            low = 0x90;
+        } else if (lead >= 0xF1 && lead <= 0xF3) {
+            continuation = 3;
+        } else if (lead == 0xF4) {
+            continuation = 3;
+            high = 0x8F;
+        } else {
+            fail("invalid UTF-8 byte");
+        }
+
+        if (text_.size() - pos_ <= continuation) {
+            fail("truncated UTF-8 sequence");
+        }
+        for (std::size_t i = 1; i <= continuation; ++i) {
+            const auto byte = static_cast<unsigned char>(text_[pos_ + i]);
+            if (byte < low || byte > high) {
+                fail("invalid UTF-8 sequence");
+            }
+            low = 0x80;
+            high = 0xBF;
+        }
+        out.append(text_, pos_, continuation + 1);
+        pos_ += continuation + 1;
+    }
+
+    void parseEscape(std::string &out)
+    {
+        ++pos_;
+        if (atEnd()) {
+            fail("unterminated string");
+        }
+        const char escaped = text_[pos_++];
+        switch (escaped) {
+        case '"':
+        case '\\':
+        case '/':
+            out.push_back(escaped);
+            return;
+        case 'b':
+            out.push_back('\b');
+            return;
+        case 'f':
+            out.push_back('\f');
+            return;
+        case 'n':
+            out.push_back('\n');
+            return;
+        case 'r':
+            out.push_back('\r');
+            return;
+        case 't':
+            out.push_back('\t');
+            return;
+        case 'u':
+            break;
+        default:
+            fail("invalid escape");
+        }
+
+        uint32_t code = parseHex4();
+        if (code >= 0xD800 && code <= 0xDBFF) {
+            if (!consume('\\') || !consume('u')) {
+                fail("missing low surrogate");
+            }
+            const uint32_t low = parseHex4();
+            if (low < 0xDC00 || low > 0xDFFF) {
+                fail("invalid low surrogate");
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        } else if (code >= 0xDC00 && code <= 0xDFFF) {
+            fail("unpaired low surrogate");
+        }
+        appendCodePoint(out, code);
+    }
+
+    uint32_t parseHex4()
+    {
+        if (text_.size() - pos_ < 4) {
+            fail("invalid \\u escape");
+        }
+        uint32_t code = 0;
+        const char *first = text_.data() + pos_;
+        auto [end, ec] = std::from_chars(first, first + 4, code, 16);
+        if (ec != std::errc() || end != first + 4) {
+            fail("invalid \\u escape");
+        }
+        pos_ += 4;
+        return code;
+    }
+
+    static void appendCodePoint(std::string &out, uint32_t code)
+    {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    // Целые без дробной части и экспоненты - int64 (отрицательные) или uint64,
+    // при переполнении и в остальных случаях - double
+    void parseNumber(Json &out)
+    {
+        const std::size_t start = pos_;
+        const bool negative = consume('-');
+        if (!consume('0')) {
+            if (!isDigit()) {
+                fail("invalid number");
+            }
+            skipDigits();
+        }
+
+        bool integer = true;
+        if (consume('.')) {
+            integer = false;
+            if (!isDigit()) {
+                fail("invalid number");
+            }
+            skipDigits();
+        }
+        if (!atEnd() && (current() == 'e' || current() == 'E')) {
+            integer = false;
+            ++pos_;
+            if (!consume('+')) {
+                consume('-');
+            }
+            if (!isDigit()) {
+                fail("invalid number");
+            }
+            skipDigits();
+        }
+
+        const char *first = text_.data() + start;
+        const char *last = text_.data() + pos_;
+        if (integer && negative) {
+            int64_t value = 0;
+            if (std::from_chars(first, last, value).ec == std::errc()) {
+                out = value;
+                return;
+            }
+        } else if (integer) {
+            uint64_t value = 0;
+            if (std::from_chars(first, last, value).ec == std::errc()) {
+                out = value;
+                return;
+            }
+        }
+
+        double value = 0;
+        if (std::from_chars(first, last, value).ec == std::errc::result_out_of_range) {
+            // from_chars не различает переполнение и исчезновение порядка
+            value = std::strtod(std::string(first, last).c_str(), nullptr);
+        }
+        if (!std::isfinite(value)) {
+            fail("number out of range");
+        }
+        out = value;
+    }
+
+    std::string_view text_;
+    std::size_t pos_ = 0;
+};
+
+} // namespace
+
+void JsonDocument::release(Json &value)
+{
+    if (auto *object = value.get_ptr<Json::object_t *>()) {
+        for (auto &[key, child] : *object) {
+            release(child);
+        }
+        object->clear();
+    } else if (auto *array = value.get_ptr<Json::array_t *>()) {
+        for (auto &child : *array) {
+            release(child);
+        }
+        array->clear();
+    }
+}
+
+Json parseJson(std::string_view text)
+{
+    Json result;
+    Parser(text).parseDocument(result);
+    return result;
+}
+
+JsonWriter::JsonWriter(std::size_t capacity)
+    : serializer_(
+          std::make_shared<nlohmann::detail::output_string_adapter<char, std::string>>(buffer_),
+          ' ',
+          nlohmann::detail::error_handler_t::replace)
+{
+    buffer_.reserve(capacity);
+}
+
+const std::string &JsonWriter::write(const Json &value)
+{
+    buffer_.clear();
+    serializer_.dump(value, false, false, 0);
+    return buffer_;
+}
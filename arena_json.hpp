@@ -0,0 +1,65 @@
+#pragma once
+
+#include "arena.hpp"
+
+#include <cstdint>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// JSON команд и ответов: узлы и контейнеры берутся из арены итерации основного цикла
+// (ключи и короткие строки помещаются в SSO std::string). Вне цикла - из кучи.
+using Json = nlohmann::basic_json<std::map,
+                                  std::vector,
+                                  std::string,
+                                  bool,
+                                  std::int64_t,
+                                  std::uint64_t,
+                                  double,
+                                  ArenaAllocator>;
+
+// Корень документа. Деструктор basic_json переносит элементы непустого объекта или массива
+// во временный std::vector, то есть выделяет память в куче; здесь контейнеры сначала
+// очищаются снизу вверх, и разрушаются уже пустыми
+class JsonDocument : public Json
+{
+public:
+    using Json::Json;
+    using Json::operator=;
+
+    JsonDocument() = default;
+    JsonDocument(const JsonDocument &) = default;
+    JsonDocument &operator=(const JsonDocument &) = default;
+    ~JsonDocument() { release(*this); }
+
+private:
+    static void release(Json &value);
+};
+
+// Разбор документа в Json. В отличие от Json::parse не держит своих буферов в куче
+// (лексер и стек разбора nlohmann выделяют их на каждый вызов), поэтому команда целиком
+// разбирается в арене. Синтаксис, числа и проверка UTF-8 - как у nlohmann, вложенность
+// ограничена. Бросает std::runtime_error с позицией ошибки.
+Json parseJson(std::string_view text);
+
+// Сериализация в строку, которая переиспользуется между вызовами: dump() каждый раз
+// создаёт новую. Вывод совпадает с dump(), результат действителен до следующего write().
+// Строка растёт только на документах длиннее всех предыдущих. Некорректный UTF-8 в строках,
+// собранных не parseJson (топики, текст брокера), заменяется на U+FFFD, а не бросает.
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::size_t capacity = 256);
+
+    JsonWriter(const JsonWriter &) = delete;
+    JsonWriter &operator=(const JsonWriter &) = delete;
+
+    const std::string &write(const Json &value);
+
+private:
+    std::string buffer_;
+    // Сериализатор nlohmann выделяет буфер отступов при создании, поэтому он один на писателя
+    nlohmann::detail::serializer<Json> serializer_;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Общие помощники программ замеров: время на операцию, перцентили, параметры запуска.
+namespace bench {
+
+// Не даёт компилятору выбросить вычисление, результат которого не используется
+template<typename T>
+inline void keep(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Среднее время одного вызова fn в наносекундах
+template<typename Fn>
+double nsPerOp(std::size_t iterations, Fn &&fn)
+{
+    const auto started = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now()
+                                                             - started;
+    return elapsed.count() / static_cast<double>(iterations);
+}
+
+// Перцентиль p (0..1) выборки, выборка сортируется
+inline double percentile(std::vector<double> &samples, double p)
+{
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const auto index = static_cast<std::size_t>(p * static_cast<double>(samples.size()));
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+// Целый параметр командной строки с номером index, иначе default_value
+inline long argOr(int argc, char **argv, int index, long default_value)
+{
+    return argc > index ? std::strtol(argv[index], nullptr, 10) : default_value;
+}
+
+} // namespace bench
@@ -0,0 +1,151 @@
+// Сжатие истории по схеме Gorilla: байт на точку, скорость кодирования и разбора блоков
+// на рядах, похожих на то, что пишет приложение, и запись через timeseries::Store.
+// Запуск: bench_gorilla [точек в ряду]
+#include "bench.hpp"
+#include "gorilla_codec.hpp"
+#include "sensor_model.hpp"
+#include "temperature_sensor_emulator.hpp"
+#include "time_series_store.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using timeseries::Sample;
+
+constexpr std::size_t block_capacity = timeseries::Store::block_size;
+constexpr int64_t start_ms = 1704067200000;
+constexpr int64_t sensor_period_ms = 5000;
+
+struct Block
+{
+    std::vector<uint8_t> data;
+    timeseries::EncoderState state;
+};
+
+std::vector<Block> encode(const std::vector<Sample> &samples)
+{
+    std::vector<Block> blocks(1);
+    blocks.back().data.resize(block_capacity);
+    for (const auto &sample : samples) {
+        auto *block = &blocks.back();
+        if (!timeseries::appendSample(block->data.data(), block_capacity, block->state, sample)) {
+            blocks.emplace_back().data.resize(block_capacity);
+            block = &blocks.back();
+            timeseries::appendSample(block->data.data(), block_capacity, block->state, sample);
+        }
+    }
+    return blocks;
+}
+
+// Эмулятор по умолчанию: независимые равномерные значения раз в 5 с
+std::vector<Sample> uniformTemperature(std::size_t count)
+{
+    TemperatureSensorEmulator<200, 300> sensor(1);
+    std::vector<Sample> samples;
+    for (std::size_t i = 0; i < count; ++i) {
+        samples.push_back({start_ms + static_cast<int64_t>(i) * sensor_period_ms,
+                           static_cast<double>(sensor.getTemperatureTenthCelsius())});
+    }
+    return samples;
+}
+
+// SENSOR_MODEL=realistic: суточный цикл, блуждание, шум; пропуски не записываются
+std::vector<Sample> realisticTemperature(std::size_t count)
+{
+    SensorBank bank(1, SensorModel{}, 1);
+    std::vector<Sample> samples;
+    for (std::size_t i = 0; i < count; ++i) {
+        const int64_t timestamp = start_ms + static_cast<int64_t>(i) * sensor_period_ms;
+        float value = 0;
+        bank.generate(static_cast<double>(timestamp / 1000 % 86400), &value);
+        if (!std::isnan(value)) {
+            samples.push_back({timestamp, std::round(value)});
+        }
+    }
+    return samples;
+}
+
+// Записи выхода: редкие нерегулярные изменения из нескольких значений
+std::vector<Sample> pinWrites(std::size_t count)
+{
+    std::mt19937 rng(1);
+    std::exponential_distribution<double> gap_s(1.0 / 30.0);
+    const double levels[] = {0, 64, 128, 255};
+    std::vector<Sample> samples;
+    int64_t timestamp = start_ms;
+    for (std::size_t i = 0; i < count; ++i) {
+        timestamp += static_cast<int64_t>(gap_s(rng) * 1000) + 1;
+        samples.push_back({timestamp, levels[rng() % 4]});
+    }
+    return samples;
+}
+
+void report(const char *name, const std::vector<Sample> &samples)
+{
+    std::vector<Block> blocks;
+    const double encode_ns = bench::nsPerOp(1, [&](std::size_t) { blocks = encode(samples); })
+                             / static_cast<double>(samples.size());
+
+    std::size_t bits = 0;
+    for (const auto &block : blocks) {
+        bits += block.state.bit_length;
+    }
+
+    std::size_t decoded = 0;
+    const double decode_ns = bench::nsPerOp(1, [&](std::size_t) {
+        for (const auto &block : blocks) {
+            decoded += timeseries::decodeBlock(block.data.data(),
+                                               block.state.bit_length,
+                                               block.state.count)
+                           .size();
+        }
+    }) / static_cast<double>(samples.size());
+
+    std::printf("%-22s %9zu %8.2f %9.1f %11.1f %11.1f\n",
+                name,
+                decoded,
+                static_cast<double>(bits) / 8.0 / static_cast<double>(samples.size()),
+                static_cast<double>(samples.size()) * 16.0 * 8.0 / static_cast<double>(bits),
+                encode_ns,
+                decode_ns);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto count = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 1000000));
+
+    std::printf("%-22s %9s %8s %9s %11s %11s\n",
+                "series",
+                "samples",
+                "B/sample",
+                "ratio",
+                "encode ns",
+                "decode ns");
+    report("temperature uniform", uniformTemperature(count));
+    report("temperature realistic", realisticTemperature(count));
+    report("pin writes", pinWrites(count));
+
+    // Полный путь записи: блокировка, поиск открытого блока, запись в отображённый файл
+    const auto path = std::filesystem::temp_directory_path()
+                      / ("bench_history_" + std::to_string(getpid()));
+    const auto samples = realisticTemperature(count);
+    double append_ns = 0;
+    {
+        timeseries::Store store(path.string(), 1024 * 1024);
+        append_ns = bench::nsPerOp(samples.size(), [&](std::size_t i) {
+            store.append(timeseries::temperature_series, samples[i].timestamp_ms, samples[i].value);
+        });
+    }
+    std::filesystem::remove(path);
+    std::printf("Store::append: %.1f ns/sample\n", append_ns);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Пропускная способность зеркала пинов в shared memory: запись через gpio::Manager с
+// зеркалом и без, чтение gpio::ShmStateReader без писателя и под непрерывной записью.
+// Запуск: bench_gpio_shm [итераций]
+#include "bench.hpp"
+#include "gpio_manager.hpp"
+#include "gpio_shm_reader.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr int pin_count = 16;
+
+void registerPins(gpio::Manager &manager)
+{
+    for (int pin = 0; pin < pin_count; ++pin) {
+        manager.registerPin({pin, gpio::PinType::Analog, gpio::PinMode::Output});
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto iterations = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 1000000));
+    const std::string shm_name = "/embedded_gpio_bench_" + std::to_string(getpid());
+
+    gpio::Manager plain;
+    registerPins(plain);
+    const double write_plain_ns = bench::nsPerOp(iterations, [&](std::size_t i) {
+        plain.writeAnalogPin(static_cast<int>(i % pin_count), static_cast<uint8_t>(i));
+    });
+
+    gpio::Manager mirrored;
+    registerPins(mirrored);
+    mirrored.exportStateToSharedMemory(shm_name);
+    const double write_mirrored_ns = bench::nsPerOp(iterations, [&](std::size_t i) {
+        mirrored.writeAnalogPin(static_cast<int>(i % pin_count), static_cast<uint8_t>(i));
+    });
+
+    gpio::ShmStateReader reader(shm_name);
+    gpio::ShmStateReader::Snapshot snapshot;
+    std::size_t failed = 0;
+    const double read_idle_ns = bench::nsPerOp(iterations, [&](std::size_t) {
+        failed += !reader.read(snapshot);
+    });
+
+    // Писатель в отдельном потоке без пауз - худший случай для повторов читателя
+    std::atomic<bool> stop{false};
+    std::atomic<std::size_t> writes{0};
+    std::thread writer([&] {
+        for (std::size_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+            mirrored.writeAnalogPin(static_cast<int>(i % pin_count), static_cast<uint8_t>(i));
+            writes.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    const double read_busy_ns = bench::nsPerOp(iterations, [&](std::size_t) {
+        failed += !reader.read(snapshot);
+    });
+    stop = true;
+    writer.join();
+
+    std::printf("pins: %d, iterations: %zu\n", pin_count, iterations);
+    std::printf("write without mirror:   %8.1f ns\n", write_plain_ns);
+    std::printf("write with mirror:      %8.1f ns\n", write_mirrored_ns);
+    std::printf("read, idle writer:      %8.1f ns\n", read_idle_ns);
+    std::printf("read, busy writer:      %8.1f ns (%zu concurrent writes)\n",
+                read_busy_ns,
+                writes.load());
+    std::printf("reads timed out:        %zu\n", failed);
+    return 0;
+}
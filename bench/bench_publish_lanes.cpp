@@ -0,0 +1,157 @@
+// Задержка сообщений полосы High, пока телеметрия забивает канал: mqtt::PublishLanes
+// с полосами по умолчанию против одной очереди без ограничений, как было до полос.
+// Канал - поток, который забирает по одному сообщению и "передаёт" его со скоростью
+// link_bytes_per_s. Запрос High ставится раз в 10 мс, телеметрия - с заданной долей
+// пропускной способности канала. Запуск: bench_publish_lanes [сообщений High]
+#include "bench.hpp"
+#include "publish_lanes.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+constexpr double link_bytes_per_s = 1000000;
+constexpr std::size_t high_size = 100;
+constexpr std::size_t telemetry_size = 200;
+// Заголовок PUBLISH и топик поверх payload
+constexpr std::size_t overhead = 30;
+
+struct Message
+{
+    std::string topic;
+    std::string payload;
+    std::function<void(bool)> on_delivered;
+    Clock::time_point enqueued;
+};
+
+// Одна очередь на всех: сообщения ложатся в полосу Normal, которой хватает на весь прогон
+constexpr std::array<mqtt::LanePolicy, mqtt::priority_count> fifo_policies = {{
+    {1, false},
+    {1 << 16, false},
+    {1, false},
+}};
+
+struct Result
+{
+    std::vector<double> high_ms;
+    uint64_t telemetry_sent = 0;
+    uint64_t telemetry_dropped = 0;
+};
+
+Result run(bool lanes, double telemetry_load, long high_count)
+{
+    mqtt::PublishLanes<Message> queue(lanes ? mqtt::default_lane_policies : fifo_policies);
+    const auto high = lanes ? mqtt::Priority::High : mqtt::Priority::Normal;
+    const auto telemetry = lanes ? mqtt::Priority::Telemetry : mqtt::Priority::Normal;
+
+    auto push = [&](mqtt::Priority priority, const char *topic, std::size_t size) {
+        queue.push(priority, topic, false, nullptr, [&](Message &message) {
+            message.topic = topic;
+            message.payload.assign(size, 'x');
+            message.enqueued = Clock::now();
+        });
+    };
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> drained{false};
+    std::atomic<long> high_received{0};
+    Result result;
+    std::thread link([&] {
+        Message message;
+        auto free_at = Clock::now();
+        while (!drained) {
+            if (!queue.tryPopInto(message)) {
+                std::this_thread::sleep_for(50us);
+                free_at = Clock::now();
+                continue;
+            }
+            const auto bytes = static_cast<double>(message.payload.size() + overhead);
+            free_at += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(bytes / link_bytes_per_s));
+            std::this_thread::sleep_until(free_at);
+            if (message.topic == "embedded/errors") {
+                const std::chrono::duration<double, std::milli> latency = Clock::now()
+                                                                          - message.enqueued;
+                result.high_ms.push_back(latency.count());
+                ++high_received;
+            } else {
+                ++result.telemetry_sent;
+            }
+        }
+    });
+
+    std::thread flood([&] {
+        const double rate = telemetry_load * link_bytes_per_s
+                            / static_cast<double>(telemetry_size + overhead);
+        if (rate <= 0) {
+            return;
+        }
+        const auto started = Clock::now();
+        for (long i = 0; !stop; ++i) {
+            std::this_thread::sleep_until(started
+                                          + std::chrono::duration_cast<Clock::duration>(
+                                              std::chrono::duration<double>(i / rate)));
+            push(telemetry, "embedded/pins/state", telemetry_size);
+        }
+    });
+
+    for (long i = 0; i < high_count; ++i) {
+        std::this_thread::sleep_for(10ms);
+        push(high, "embedded/errors", high_size);
+    }
+    stop = true;
+    flood.join();
+    // Все запросы High должны дойти; хвост телеметрии в одной очереди не дожидаемся
+    const auto deadline = Clock::now() + 30s;
+    while (high_received < high_count && Clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    drained = true;
+    link.join();
+    result.telemetry_dropped = queue.dropped(telemetry);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto high_count = bench::argOr(argc, argv, 1, 300);
+
+    std::printf("%-6s %10s %10s %10s %10s %12s %12s\n",
+                "queue",
+                "telemetry",
+                "high",
+                "p50, ms",
+                "p99, ms",
+                "tele sent",
+                "tele dropped");
+    for (const double load : {0.0, 0.5, 2.0}) {
+        for (const bool lanes : {false, true}) {
+            auto result = run(lanes, load, high_count);
+            const auto received = result.high_ms.size();
+            const auto p50 = bench::percentile(result.high_ms, 0.5);
+            const auto p99 = bench::percentile(result.high_ms, 0.99);
+            std::printf("%-6s %9.1fx %10zu %10.2f %10.2f %12llu %12llu\n",
+                        lanes ? "lanes" : "fifo",
+                        load,
+                        received,
+                        p50,
+                        p99,
+                        static_cast<unsigned long long>(result.telemetry_sent),
+                        static_cast<unsigned long long>(result.telemetry_dropped));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Стоимость сопоставления топика с подписками: префиксное дерево mqtt::TopicRouter против
+// перебора всех фильтров, как было до него. Запуск: bench_topic_router [итераций]
+#include "bench.hpp"
+#include "topic_router.hpp"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Сопоставление одного фильтра с топиком по уровням, как при переборе
+bool filterMatches(std::string_view filter, std::string_view topic)
+{
+    while (true) {
+        const auto filter_end = filter.find('/');
+        const auto level = filter.substr(0, filter_end);
+        if (level == "#") {
+            return true;
+        }
+        const auto topic_end = topic.find('/');
+        if (level != "+" && level != topic.substr(0, topic_end)) {
+            return false;
+        }
+        if (filter_end == std::string_view::npos || topic_end == std::string_view::npos) {
+            return filter_end == topic_end
+                   || (topic_end == std::string_view::npos && filter.substr(filter_end) == "/#");
+        }
+        filter.remove_prefix(filter_end + 1);
+        topic.remove_prefix(topic_end + 1);
+    }
+}
+
+// Подписки приложения и count подписок на отдельные устройства
+std::vector<std::string> makeFilters(std::size_t count)
+{
+    std::vector<std::string> filters = {"embedded/control",
+                                        "embedded/pins/+/set",
+                                        "embedded/config",
+                                        "embedded/history/query"};
+    for (std::size_t i = 0; i < count; ++i) {
+        filters.push_back("devices/" + std::to_string(i) + "/set");
+    }
+    filters.push_back("devices/+/status");
+    filters.push_back("devices/#");
+    return filters;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto iterations = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 1000000));
+
+    const std::vector<std::string> topics = {"embedded/control",
+                                             "embedded/pins/13/set",
+                                             "devices/17/set",
+                                             "devices/42/status",
+                                             "unrelated/topic/with/levels"};
+    const std::string payload;
+
+    std::printf("%10s %14s %14s %10s\n", "filters", "trie ns/msg", "scan ns/msg", "matches");
+    for (std::size_t devices : {0, 100, 1000, 10000}) {
+        const auto filters = makeFilters(devices);
+
+        std::size_t routed = 0;
+        mqtt::TopicRouter router;
+        for (const auto &filter : filters) {
+            router.add(filter, [&routed](const auto &, const auto &, const auto &) { ++routed; });
+        }
+
+        const double trie_ns = bench::nsPerOp(iterations, [&](std::size_t i) {
+            router.route(topics[i % topics.size()], payload);
+        });
+
+        std::size_t scanned = 0;
+        // Перебор медленнее на порядки: меньше итераций, чтобы замер шёл секунды
+        const double scan_ns = bench::nsPerOp(iterations / (devices / 100 + 1), [&](std::size_t i) {
+            for (const auto &filter : filters) {
+                scanned += filterMatches(filter, topics[i % topics.size()]);
+            }
+        });
+        bench::keep(scanned);
+
+        std::printf("%10zu %14.1f %14.1f %10zu\n", filters.size(), trie_ns, scan_ns, routed);
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Трассировка: стоимость записи интервала и сводка перцентилей по этапам команд,
+// прогнанных через Application с подделками клиента и GPIO.
+// Запуск: bench_trace [команд]
+#include "application.hpp"
+#include "bench.hpp"
+#include "fakes.hpp"
+#include "gpio/gpio_manager.hpp"
+#include "trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const AppConfig config{.max_reconnect_attempts = 0,
+                       .button_debounce_ms = 50,
+                       .temperature_period_ms = 1000000000,
+                       .reconnect_interval_ms = 100,
+                       .pin_snapshot_period_ms = 1000000000,
+                       .pins = PinConfig{.red_pin = 3,
+                                         .green_pin = 5,
+                                         .blue_pin = 6,
+                                         .temperature_pin = 0,
+                                         .button_pin = 2,
+                                         .led_pin = 13},
+                       .config_file = {},
+                       .status_file = {}};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // Команда оставляет в буфере основного цикла 4-5 интервалов: при большем числе команд
+    // в сводку попадут только последние
+    const auto commands = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 800));
+
+    const double disabled_ns = bench::nsPerOp(10000000, [](std::size_t i) {
+        trace::record("bench.span", 0, 0, static_cast<int64_t>(i));
+    });
+    trace::enable(true);
+    const double enabled_ns = bench::nsPerOp(10000000, [](std::size_t i) {
+        trace::record("bench.span", 0, 0, static_cast<int64_t>(i));
+    });
+    std::printf("record: %.1f ns disabled, %.1f ns enabled\n", disabled_ns, enabled_ns);
+
+    std::cout.setstate(std::ios::failbit);
+    std::cerr.setstate(std::ios::failbit);
+
+    std::vector<double> round_trip_us;
+    {
+        auto mqtt_impl = std::make_unique<fakes::MqttClient>();
+        auto &mqtt = *mqtt_impl;
+        Application app(config,
+                        std::move(mqtt_impl),
+                        std::make_unique<gpio::Manager>(),
+                        std::make_unique<fakes::TemperatureSensor>(),
+                        nullptr,
+                        nullptr,
+                        std::make_shared<fakes::ScaledClock>(100000));
+        std::thread runner([&app] { app.run(); });
+        // Снимок пинов - первая публикация после подключения, подписки уже есть
+        mqtt.waitFor(
+            [](const auto &message) { return message.topic == PinStateSync::snapshot_topic; },
+            std::chrono::seconds(5));
+
+        const std::string requests[] = {
+            R"({"command":"set_rgb","red":10,"green":20,"blue":30})",
+            R"({"command":"set_pin","pin":13,"value":1})",
+            R"({"command":"set_rgb","red":1,"green":2,"blue":3})",
+            R"({"command":"set_pin","pin":13,"value":0})",
+        };
+        for (std::size_t i = 0; i < commands; ++i) {
+            const auto started = std::chrono::steady_clock::now();
+            if (!mqtt.request("embedded/control", requests[i % std::size(requests)])) {
+                std::printf("no reply to request %zu\n", i);
+                break;
+            }
+            const std::chrono::duration<double, std::micro> elapsed
+                = std::chrono::steady_clock::now() - started;
+            round_trip_us.push_back(elapsed.count());
+        }
+
+        mqtt.setFailConnect(true);
+        mqtt.dropSession();
+        runner.join();
+    }
+
+    // Приложение разрушено, его потоки остановлены: выгрузка видит все интервалы
+    std::printf(
+        "%-20s %8s %9s %9s %9s %9s\n", "span", "n", "p50 us", "p90 us", "p99 us", "max us");
+    for (const auto &s : trace::summarize(trace::collect())) {
+        if (s.name == "bench.span") {
+            continue;
+        }
+        std::printf("%-20s %8zu %9.1f %9.1f %9.1f %9.1f\n",
+                    s.name.c_str(),
+                    s.count,
+                    s.p50_us,
+                    s.p90_us,
+                    s.p99_us,
+                    s.max_us);
+    }
+    std::printf("%-20s %8zu %9.1f %9.1f %9.1f\n",
+                "request round trip",
+                round_trip_us.size(),
+                bench::percentile(round_trip_us, 0.5),
+                bench::percentile(round_trip_us, 0.9),
+                bench::percentile(round_trip_us, 0.99));
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Нагрузочный прогон Application::run() с подделками клиента MQTT и GPIO и SimulatedClock:
+// потоки-отправители шлют корректные и ошибочные команды, пачки, запросы истории, смену
+// конфигурации и перезапуски, поток GPIO нажимает кнопку, брокер периодически рвёт
+// соединение. Раз в секунду печатает число сообщений, ответов и RSS: после первой секунды
+// RSS расти не должен (очереди ограничены). Для проверки гонок собирается
+// с -DCMAKE_CXX_FLAGS=-fsanitize=thread.
+// Запуск: stress_app [секунд] [потоков-отправителей]
+#include "application.hpp"
+#include "bench.hpp"
+#include "fakes.hpp"
+#include "journal/pin_journal.hpp"
+#include "timeseries/time_series_store.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+const AppConfig config{.max_reconnect_attempts = 3,
+                       .button_debounce_ms = 0,
+                       .temperature_period_ms = 5,
+                       .reconnect_interval_ms = 5,
+                       .pin_snapshot_period_ms = 20,
+                       .pins = PinConfig{.red_pin = 3,
+                                         .green_pin = 5,
+                                         .blue_pin = 6,
+                                         .temperature_pin = 0,
+                                         .button_pin = 2,
+                                         .led_pin = 13},
+                       .config_file = {},
+                       .status_file = {}};
+
+struct Message
+{
+    const char *topic;
+    const char *payload;
+};
+
+const Message messages[] = {
+    {"embedded/control", R"({"command":"set_rgb","red":1,"green":2,"blue":3})"},
+    {"embedded/control", R"({"command":"fade_rgb","red":200,"green":0,"blue":9,"duration_ms":30})"},
+    {"embedded/control",
+     R"([{"command":"set_pin","pin":13,"value":1},)"
+     R"({"command":"set_rgb","red":5,"green":6,"blue":7}])"},
+    {"embedded/control", R"({"command":"restart","mode":"warm"})"},
+    {"embedded/control", R"({"command":"restart"})"},
+    {"embedded/control", R"({"command":"nope"})"},
+    {"embedded/control", "{bad json"},
+    {"embedded/pins/3/set", R"({"value":17})"},
+    {"embedded/pins/13/set", R"({"value":0})"},
+    {"embedded/history/query", R"({"series":"pin/3"})"},
+    {"embedded/config", R"({"pins":{"red":5,"green":3}})"},
+    {"embedded/config", R"({"pins":{"red":3,"green":5}})"},
+};
+
+struct Counters
+{
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> replies{0};
+};
+
+long rssKb()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size = 0;
+    long resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto seconds = bench::argOr(argc, argv, 1, 5);
+    const auto senders = bench::argOr(argc, argv, 2, 4);
+
+    const auto dir = std::filesystem::temp_directory_path()
+                     / ("stress_app_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    std::cout.setstate(std::ios::failbit);
+    std::cerr.setstate(std::ios::failbit);
+
+    Counters counters;
+    auto mqtt_impl = std::make_unique<fakes::MqttClient>();
+    auto gpio_impl = std::make_unique<fakes::Gpio>();
+    auto &mqtt = *mqtt_impl;
+    auto &gpio = *gpio_impl;
+    mqtt.setRecordPublished(false);
+    mqtt.setPublishHook(
+        [counters = &counters](const std::string &topic, const std::string &, const auto &) {
+            counters->published.fetch_add(1, std::memory_order_relaxed);
+            if (topic.rfind("stress/reply/", 0) == 0) {
+                counters->replies.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+    Application app(config,
+                    std::move(mqtt_impl),
+                    std::move(gpio_impl),
+                    std::make_unique<fakes::TemperatureSensor>(),
+                    std::make_unique<timeseries::Store>((dir / "history.bin").string(),
+                                                        64 * 1024),
+                    std::make_unique<journal::PinJournal>((dir / "journal.bin").string(), 256),
+                    std::make_shared<SimulatedClock>());
+    std::thread runner([&app] { app.run(); });
+    // Подписки оформляются в начале run(), доставка в подделке идёт без блокировки:
+    // отправители стартуют после первой публикации
+    while (counters.published.load() == 0) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    std::atomic<bool> stop{false};
+    // Клиент mosquitto вызывает колбэки сообщений из одного сетевого потока
+    std::mutex network;
+    std::vector<std::thread> threads;
+    for (long sender = 0; sender < senders; ++sender) {
+        threads.emplace_back([&, sender] {
+            mqtt::MessageProperties with_reply;
+            with_reply.response_topic = "stress/reply/" + std::to_string(sender);
+            const mqtt::MessageProperties without_reply;
+            for (std::size_t i = static_cast<std::size_t>(sender); !stop; ++i) {
+                const auto &message = messages[i % std::size(messages)];
+                {
+                    std::lock_guard<std::mutex> lock(network);
+                    mqtt.deliver(message.topic,
+                                 message.payload,
+                                 i % 3 == 0 ? with_reply : without_reply);
+                }
+                counters.delivered.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        while (!stop) {
+            try {
+                gpio.injectDigitalValue(config.pins.button_pin, gpio::DigitalValue::High);
+                gpio.injectDigitalValue(config.pins.button_pin, gpio::DigitalValue::Low);
+            } catch (const std::runtime_error &) {
+                // Пины сняты на время перезапуска
+            }
+            std::this_thread::sleep_for(100us);
+        }
+    });
+    threads.emplace_back([&] {
+        while (!stop) {
+            std::this_thread::sleep_for(50ms);
+            mqtt.dropSession();
+        }
+    });
+
+    long first_rss = 0;
+    uint64_t last_delivered = 0;
+    uint64_t last_replies = 0;
+    std::printf(
+        "%4s %12s %12s %12s %10s\n", "t, s", "messages/s", "replies/s", "published", "rss, KB");
+    for (long second = 1; second <= seconds; ++second) {
+        std::this_thread::sleep_for(1s);
+        const auto delivered = counters.delivered.load();
+        const auto replies = counters.replies.load();
+        const long rss = rssKb();
+        if (second == 1) {
+            first_rss = rss;
+        }
+        std::printf("%4ld %12llu %12llu %12llu %10ld\n",
+                    second,
+                    static_cast<unsigned long long>(delivered - last_delivered),
+                    static_cast<unsigned long long>(replies - last_replies),
+                    static_cast<unsigned long long>(counters.published.load()),
+                    rss);
+        last_delivered = delivered;
+        last_replies = replies;
+    }
+
+    stop = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    std::printf("rss growth after the first second: %ld KB\n", rssKb() - first_rss);
+
+    // Без брокера приложение исчерпывает попытки переподключения и выходит из run()
+    mqtt.setFailConnect(true);
+    mqtt.dropSession();
+    runner.join();
+
+    std::filesystem::remove_all(dir);
+    return counters.replies.load() > 0 ? 0 : 1;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 struct PinConfig
 {
     int red_pin;
@@ -8,10 +10,23 @@ struct PinConfig
     int temperature_pin;
     int button_pin;
     int led_pin;
+
+    bool operator==(const PinConfig &) const = default;
 };
 
 struct AppConfig
 {
     int max_reconnect_attempts;
+    int button_debounce_ms;
+    int temperature_period_ms;
+    int reconnect_interval_ms;
+    // Период сохраняемого снимка состояния пинов в embedded/pins/snapshot
+    int pin_snapshot_period_ms;
     PinConfig pins;
+    // Файл для горячей перезагрузки конфигурации, пустая строка - не отслеживать
+    std::string config_file;
+    // Файл состояния для проверок готовности и живости, пустая строка - не писать
+    std::string status_file;
+
+    bool operator==(const AppConfig &) const = default;
 };
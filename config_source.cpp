@@ -0,0 +1,137 @@
+#include "config_source.hpp"
+#include <fstream>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+void readInt(const nlohmann::json &data, const char *key, int &target)
+{
+    if (!data.contains(key)) {
+        return;
+    }
+    const auto &value = data[key];
+    // Числа вне int отвергаются, а не усекаются до младших 32 бит
+    const bool fits = value.is_number_unsigned()
+                          ? value.get<uint64_t>() <= std::numeric_limits<int>::max()
+                          : value.is_number_integer()
+                                && value.get<int64_t>() >= std::numeric_limits<int>::min()
+                                && value.get<int64_t>() <= std::numeric_limits<int>::max();
+    if (!fits) {
+        throw std::invalid_argument(std::string("Invalid '") + key + "' field");
+    }
+    target = value;
+}
+
+} // namespace
+
+AppConfig applyConfigJson(const AppConfig &base, const std::string &json)
+{
+    nlohmann::json data;
+    try {
+        data = nlohmann::json::parse(json);
+    } catch (const std::exception &e) {
+        throw std::invalid_argument("Invalid JSON format: " + std::string(e.what()));
+    }
+
+    if (!data.is_object()) {
+        throw std::invalid_argument("Configuration must be a JSON object");
+    }
+
+    AppConfig config = base;
+    readInt(data, "max_reconnect_attempts", config.max_reconnect_attempts);
+    readInt(data, "button_debounce_ms", config.button_debounce_ms);
+    readInt(data, "temperature_period_ms", config.temperature_period_ms);
+    readInt(data, "reconnect_interval_ms", config.reconnect_interval_ms);
+    readInt(data, "pin_snapshot_period_ms", config.pin_snapshot_period_ms);
+
+    if (data.contains("pins")) {
+        const auto &pins = data["pins"];
+        if (!pins.is_object()) {
+            throw std::invalid_argument("Invalid 'pins' field");
+        }
+        readInt(pins, "red", config.pins.red_pin);
+        readInt(pins, "green", config.pins.green_pin);
+        readInt(pins, "blue", config.pins.blue_pin);
+        readInt(pins, "temperature", config.pins.temperature_pin);
+        readInt(pins, "button", config.pins.button_pin);
+        readInt(pins, "led", config.pins.led_pin);
+    }
+
+    validateConfig(config);
+    return config;
+}
+
+void validateConfig(const AppConfig &config)
+{
+    if (config.max_reconnect_attempts < 0) {
+        throw std::invalid_argument("'max_reconnect_attempts' must be non-negative");
+    }
+    if (config.button_debounce_ms < 0) {
+        throw std::invalid_argument("'button_debounce_ms' must be non-negative");
+    }
+    if (config.temperature_period_ms <= 0 || config.reconnect_interval_ms <= 0
+        || config.pin_snapshot_period_ms <= 0) {
+        throw std::invalid_argument("Periods must be positive");
+    }
+
+    const auto &pins = config.pins;
+    const int numbers[] = {pins.red_pin,
+                           pins.green_pin,
+                           pins.blue_pin,
+                           pins.temperature_pin,
+                           pins.button_pin,
+                           pins.led_pin};
+    std::set<int> unique;
+    for (int number : numbers) {
+        if (number < 0) {
+            throw std::invalid_argument("Pin numbers must be non-negative");
+        }
+        if (!unique.insert(number).second) {
+            throw std::invalid_argument("Pin " + std::to_string(number) + " is assigned twice");
+        }
+    }
+}
+
+std::string configToJson(const AppConfig &config)
+{
+    nlohmann::json data;
+    data["max_reconnect_attempts"] = config.max_reconnect_attempts;
+    data["button_debounce_ms"] = config.button_debounce_ms;
+    data["temperature_period_ms"] = config.temperature_period_ms;
+    data["reconnect_interval_ms"] = config.reconnect_interval_ms;
+    data["pin_snapshot_period_ms"] = config.pin_snapshot_period_ms;
+    data["pins"] = {{"red", config.pins.red_pin},
+                    {"green", config.pins.green_pin},
+                    {"blue", config.pins.blue_pin},
+                    {"temperature", config.pins.temperature_pin},
+                    {"button", config.pins.button_pin},
+                    {"led", config.pins.led_pin}};
+    return data.dump();
+}
+
+ConfigFileWatcher::ConfigFileWatcher(std::string path)
+    : path_(std::move(path))
+{}
+
+std::optional<std::string> ConfigFileWatcher::readIfChanged()
+{
+    std::error_code ec;
+    auto write_time = std::filesystem::last_write_time(path_, ec);
+    if (ec || write_time == last_write_time_) {
+        return std::nullopt;
+    }
+
+    std::ifstream file(path_);
+    if (!file) {
+        return std::nullopt;
+    }
+    last_write_time_ = write_time;
+
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+// Накладывает поля JSON-документа на base (отсутствующие поля сохраняются):
+// {
+//   "max_reconnect_attempts": 5, "button_debounce_ms": 50,
+//   "temperature_period_ms": 5000, "reconnect_interval_ms": 2000,
+//   "pin_snapshot_period_ms": 30000,
+//   "pins": {"red": 3, "green": 5, "blue": 6, "temperature": 0, "button": 2, "led": 13}
+// }
+// Бросает std::invalid_argument для некорректного документа или результата.
+AppConfig applyConfigJson(const AppConfig &base, const std::string &json);
+
+// Бросает std::invalid_argument, если значения вне допустимых диапазонов
+// или несколько ролей назначены на один пин
+void validateConfig(const AppConfig &config);
+
+std::string configToJson(const AppConfig &config);
+
+// Отслеживание изменений файла конфигурации по времени модификации
+class ConfigFileWatcher
+{
+public:
+    explicit ConfigFileWatcher(std::string path);
+
+    // Содержимое файла, если он изменился с прошлого вызова
+    std::optional<std::string> readIfChanged();
+
+private:
+    std::string path_;
+    std::optional<std::filesystem::file_time_type> last_write_time_;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "error_codes.hpp"
+#include "gpio/gpio_types.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <variant>
+
+// Команды embedded/control после проверки полей. Проверка отделена от выполнения, чтобы
+// пачку команд можно было проверить целиком до первой записи в GPIO.
+namespace control {
+
+// Cold - полный перезапуск с разрывом MQTT и сбросом выходов (с журналом пинов - с их
+// восстановлением из журнала),
+// Warm - переинициализация GPIO на месте с сохранением состояния пинов и MQTT-сессии
+enum class RestartMode {
+    Cold,
+    Warm
+};
+
+struct Rgb
+{
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+};
+
+struct Restart
+{
+    RestartMode mode;
+};
+
+struct SetRgb
+{
+    Rgb rgb;
+};
+
+struct FadeRgb
+{
+    Rgb rgb;
+    int duration_ms;
+    gpio::Easing easing;
+};
+
+struct SetPin
+{
+    int pin;
+    int value;
+};
+
+using Command = std::variant<Restart, SetRgb, FadeRgb, SetPin>;
+
+// Atomic - при ошибке проверки любой команды не выполняется ни одна, при сбое GPIO выходы
+// возвращаются к состоянию до пачки; Sequential - команды выполняются по порядку,
+// некорректные пропускаются
+enum class BatchMode {
+    Atomic,
+    Sequential
+};
+
+struct BatchItem
+{
+    std::string name;
+    Command command;
+    // Причина отказа, команда тогда не выполняется
+    std::optional<ErrorCode> error;
+    std::string detail;
+    bool rate_limited = false;
+    bool executed = false;
+};
+
+} // namespace control
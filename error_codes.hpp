@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Коды ошибок, публикуемые в embedded/errors. Значения входят в протокол:
+// новые коды добавляются только в конец, существующие не переиспользуются.
+enum class ErrorCode : uint16_t {
+    InvalidJson = 1,
+    InvalidCommandField,
+    UnsupportedCommand,
+    InvalidRestartMode,
+    InvalidRgbFields,
+    RgbOutOfRange,
+    InvalidDuration,
+    DurationOutOfRange,
+    InvalidEasing,
+    InvalidPinTopic,
+    InvalidPinValue,
+    DigitalValueOutOfRange,
+    AnalogValueOutOfRange,
+    PinNotControllable,
+    GpioFailure,
+    InvalidConfig,
+    InvalidHistoryQuery,
+    HistoryUnavailable,
+    SensorDropout,
+    InvalidBatch,
+    InvalidPinField,
+};
+
+struct ErrorDescription
+{
+    ErrorCode code;
+    std::string_view message;
+};
+
+// Тексты хранятся только здесь, при сообщении об ошибке передаётся код
+inline constexpr ErrorDescription error_descriptions[] = {
+    {ErrorCode::InvalidJson, "Invalid JSON format"},
+    {ErrorCode::InvalidCommandField, "Missing or invalid 'command' field"},
+    {ErrorCode::UnsupportedCommand, "Unsupported command"},
+    {ErrorCode::InvalidRestartMode, "Invalid 'mode' field, expected 'cold' or 'warm'"},
+    {ErrorCode::InvalidRgbFields, "Missing or invalid 'red', 'green', or 'blue' fields"},
+    {ErrorCode::RgbOutOfRange, "RGB values must be in range [0, 255]"},
+    {ErrorCode::InvalidDuration, "Missing or invalid 'duration_ms' field"},
+    {ErrorCode::DurationOutOfRange, "'duration_ms' must be in range [0, 60000]"},
+    {ErrorCode::InvalidEasing, "Invalid 'easing' field"},
+    {ErrorCode::InvalidPinTopic, "Invalid pin in topic"},
+    {ErrorCode::InvalidPinValue, "Missing or invalid 'value' field"},
+    {ErrorCode::DigitalValueOutOfRange, "Digital pin value must be 0 or 1"},
+    {ErrorCode::AnalogValueOutOfRange, "Analog pin value must be in range [0, 255]"},
+    {ErrorCode::PinNotControllable, "Pin is not a controllable output"},
+    {ErrorCode::GpioFailure, "GPIO error"},
+    {ErrorCode::InvalidConfig, "Invalid configuration"},
+    {ErrorCode::InvalidHistoryQuery, "Invalid history query"},
+    {ErrorCode::HistoryUnavailable, "History recording is disabled"},
+    {ErrorCode::SensorDropout, "Temperature sensor returned no sample"},
+    {ErrorCode::InvalidBatch,
+     "Invalid batch: expected 1 to 32 commands and mode 'atomic' or 'sequential'"},
+    {ErrorCode::InvalidPinField, "Missing or invalid 'pin' field"},
+};
+
+inline constexpr std::size_t error_code_count = std::size(error_descriptions);
+
+// Таблица упорядочена по кодам, поэтому описание находится по индексу
+constexpr std::size_t errorIndex(ErrorCode code)
+{
+    return static_cast<std::size_t>(code) - 1;
+}
+
+constexpr bool errorTableIsDense()
+{
+    for (std::size_t i = 0; i < error_code_count; ++i) {
+        if (errorIndex(error_descriptions[i].code) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(errorTableIsDense(), "error_descriptions must list every ErrorCode in order");
+
+constexpr std::string_view errorMessage(ErrorCode code)
+{
+    return error_descriptions[errorIndex(code)].message;
+}
@@ -0,0 +1,92 @@
+#include "error_reporter.hpp"
+#include <nlohmann/json.hpp>
+
+namespace {
+
+// Не длиннее max_length байт и без обрезанного посередине символа UTF-8
+std::string_view utf8Prefix(std::string_view text, std::size_t max_length)
+{
+    if (text.size() <= max_length) {
+        return text;
+    }
+    std::size_t length = max_length;
+    while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) {
+        --length;
+    }
+    return text.substr(0, length);
+}
+
+} // namespace
+
+ErrorReporter::ErrorReporter(std::chrono::milliseconds window,
+                             PublishFn publish,
+                             Clock::time_point now)
+    : window_(window)
+    , publish_(std::move(publish))
+    , window_start_(now)
+{}
+
+void ErrorReporter::report(ErrorCode code, std::string_view detail, Clock::time_point now)
+{
+    auto &slot = slots_[errorIndex(code)];
+    if (slot.count++ == 0) {
+        slot.detail.assign(utf8Prefix(detail, max_detail_length));
+    }
+
+    if (++pending_ >= max_batch_errors) {
+        publishBatch(now);
+    }
+}
+
+void ErrorReporter::addDropped(uint64_t rate_limited, uint64_t queue_full)
+{
+    rate_limited_ += rate_limited;
+    queue_full_ += queue_full;
+}
+
+void ErrorReporter::flush(Clock::time_point now)
+{
+    if (now - window_start_ < window_) {
+        return;
+    }
+    publishBatch(now);
+}
+
+void ErrorReporter::publishBatch(Clock::time_point now)
+{
+    window_start_ = now;
+
+    if (pending_ == 0 && rate_limited_ == 0 && queue_full_ == 0) {
+        return;
+    }
+
+    nlohmann::json batch;
+    batch["seq"] = sequence_++;
+    batch["errors"] = nlohmann::json::array();
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        auto &slot = slots_[i];
+        if (slot.count == 0) {
+            continue;
+        }
+
+        nlohmann::json entry;
+        entry["code"] = static_cast<int>(error_descriptions[i].code);
+        entry["message"] = error_descriptions[i].message;
+        entry["count"] = slot.count;
+        if (!slot.detail.empty()) {
+            entry["detail"] = slot.detail;
+        }
+        batch["errors"].push_back(std::move(entry));
+
+        slot.count = 0;
+        slot.detail.clear();
+    }
+    batch["dropped"] = {{"rate_limited", rate_limited_}, {"queue_full", queue_full_}};
+
+    pending_ = 0;
+    rate_limited_ = 0;
+    queue_full_ = 0;
+
+    // Деталь - текст извне (топик, имя команды) и может не быть корректным UTF-8
+    publish_(batch.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "error_codes.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Копит ошибки обработки команд по кодам и отправляет их пачкой: по таймеру или
+// при накоплении max_batch_errors, чтобы поток некорректных сообщений не удваивал
+// исходящий трафик. Не потокобезопасен, используется из основного цикла.
+class ErrorReporter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using PublishFn = std::function<void(const std::string &payload)>;
+
+    // Порог досрочной отправки пачки
+    static constexpr uint64_t max_batch_errors = 64;
+    // Длина сохраняемой детали ошибки (текст исключения, топик и т.п.)
+    static constexpr std::size_t max_detail_length = 128;
+
+    ErrorReporter(std::chrono::milliseconds window,
+                  PublishFn publish,
+                  Clock::time_point now = Clock::now());
+
+    // Повтор уже учтённого в пачке кода - только инкремент счётчика,
+    // деталь копируется лишь для первого вхождения
+    void report(ErrorCode code, std::string_view detail = {}, Clock::time_point now = Clock::now());
+    // Учесть сообщения, отброшенные до обработки (ограничение частоты, переполнение очереди)
+    void addDropped(uint64_t rate_limited, uint64_t queue_full);
+
+    // Публикует пачку, если окно истекло и есть что сообщить
+    void flush(Clock::time_point now = Clock::now());
+
+private:
+    struct Slot
+    {
+        uint64_t count = 0;
+        std::string detail;
+    };
+
+    void publishBatch(Clock::time_point now);
+
+    std::chrono::milliseconds window_;
+    PublishFn publish_;
+    Clock::time_point window_start_;
+
+    std::array<Slot, error_code_count> slots_{};
+    uint64_t pending_ = 0;
+    uint64_t rate_limited_ = 0;
+    uint64_t queue_full_ = 0;
+    uint64_t sequence_ = 0;
+};
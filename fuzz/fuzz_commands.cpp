@@ -0,0 +1,146 @@
+// libFuzzer: сообщение от брокера проходит весь путь команды в работающем Application -
+// разбор JSON, проверку, выполнение в GPIO, ответ и отчёт об ошибках. Первый байт входа
+// выбирает топик, остальные - payload. На каждое сообщение должен прийти ответ: его отсутствие
+// тоже находка. Приложение одно на весь прогон, поэтому состояние (пины, конфигурация)
+// переживает входы.
+// Запуск: fuzz_commands [-max_total_time=60] fuzz/corpus
+#include "application.hpp"
+#include "fakes.hpp"
+#include "journal/pin_journal.hpp"
+#include "timeseries/time_series_store.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Холодный перезапуск из корпуса проходит через переподключение
+const AppConfig config{.max_reconnect_attempts = 3,
+                       .button_debounce_ms = 50,
+                       .temperature_period_ms = 60000,
+                       .reconnect_interval_ms = 100,
+                       .pin_snapshot_period_ms = 30000,
+                       .pins = PinConfig{.red_pin = 3,
+                                         .green_pin = 5,
+                                         .blue_pin = 6,
+                                         .temperature_pin = 0,
+                                         .button_pin = 2,
+                                         .led_pin = 13},
+                       .config_file = {},
+                       .status_file = {}};
+
+// Первые байты корпуса - цифры '0'..'5', они выбирают топики по порядку
+const std::string topics[] = {
+    "embedded/control",
+    "embedded/pins/3/set",
+    "embedded/pins/13/set",
+    "embedded/pins/99/set",
+    "embedded/config",
+    "embedded/history/query",
+};
+
+class Harness
+{
+public:
+    Harness()
+        : dir_(std::filesystem::temp_directory_path()
+               / ("fuzz_commands_" + std::to_string(getpid())))
+    {
+        std::filesystem::create_directories(dir_);
+        std::cout.setstate(std::ios::failbit);
+        std::cerr.setstate(std::ios::failbit);
+
+        auto mqtt_impl = std::make_unique<fakes::MqttClient>();
+        mqtt_ = mqtt_impl.get();
+        mqtt_->setRecordPublished(false);
+        mqtt_->setPublishHook(
+            [counters = &counters_](const std::string &topic, const std::string &, const auto &) {
+                counters->published.fetch_add(1);
+                if (topic == reply_topic) {
+                    counters->replies.fetch_add(1);
+                }
+            });
+        properties_.response_topic = reply_topic;
+
+        // Ускоренное время: лимиты частоты не отбрасывают входы молча
+        app_ = std::make_unique<Application>(
+            config,
+            std::move(mqtt_impl),
+            std::make_unique<fakes::Gpio>(),
+            std::make_unique<fakes::TemperatureSensor>(),
+            std::make_unique<timeseries::Store>((dir_ / "history.bin").string(), 64 * 1024),
+            std::make_unique<journal::PinJournal>((dir_ / "journal.bin").string(), 256),
+            std::make_shared<fakes::ScaledClock>(100000));
+        runner_ = std::thread([this] { app_->run(); });
+        // Подписки оформляются в начале run()
+        while (counters_.published.load() == 0) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    ~Harness()
+    {
+        mqtt_->setFailConnect(true);
+        mqtt_->dropSession();
+        runner_.join();
+        app_.reset();
+        std::filesystem::remove_all(dir_);
+    }
+
+    void send(const std::string &topic, const std::string &payload)
+    {
+        const auto expected = counters_.replies.load() + 1;
+        if (!mqtt_->deliver(topic, payload, properties_)) {
+            return;
+        }
+        const auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (counters_.replies.load() < expected) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                std::fprintf(stderr, "no reply to %s\n", topic.c_str());
+                std::abort();
+            }
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    static inline const std::string reply_topic = "fuzz/reply";
+
+    struct Counters
+    {
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> replies{0};
+    };
+
+    std::filesystem::path dir_;
+    Counters counters_;
+    fakes::MqttClient *mqtt_ = nullptr;
+    mqtt::MessageProperties properties_;
+    std::unique_ptr<Application> app_;
+    std::thread runner_;
+};
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, std::size_t size)
+{
+    static Harness harness;
+    if (size == 0) {
+        return 0;
+    }
+    harness.send(topics[data[0] % std::size(topics)],
+                 std::string(reinterpret_cast<const char *>(data) + 1, size - 1));
+    return 0;
+}
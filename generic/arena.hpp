@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+// Арена с освобождением всего сразу: память выдаётся сдвигом указателя в буфере,
+// выделенном один раз, и возвращается целиком через reset(). Для короткоживущих
+// объектов одной итерации цикла (JSON команды и ответа), чтобы они не дробили кучу.
+class Arena
+{
+public:
+    explicit Arena(std::size_t size)
+        : buffer_(std::make_unique<std::byte[]>(size))
+        , size_(size)
+    {}
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // nullptr, если места не осталось
+    void *allocate(std::size_t bytes, std::size_t alignment)
+    {
+        auto base = reinterpret_cast<std::uintptr_t>(buffer_.get());
+        std::size_t offset = (base + used_ + alignment - 1) / alignment * alignment - base;
+        if (offset + bytes > size_) {
+            ++overflows_;
+            return nullptr;
+        }
+        used_ = offset + bytes;
+        return buffer_.get() + offset;
+    }
+
+    bool owns(const void *p) const
+    {
+        auto *byte = static_cast<const std::byte *>(p);
+        return byte >= buffer_.get() && byte < buffer_.get() + size_;
+    }
+
+    // Все выданные объекты должны быть уже разрушены
+    void reset() { used_ = 0; }
+
+    std::size_t used() const { return used_; }
+    // Сколько раз арены не хватило и память взята из кучи
+    std::size_t overflows() const { return overflows_; }
+
+private:
+    std::unique_ptr<std::byte[]> buffer_;
+    std::size_t size_;
+    std::size_t used_ = 0;
+    std::size_t overflows_ = 0;
+};
+
+namespace detail {
+inline thread_local Arena *current_arena = nullptr;
+} // namespace detail
+
+// Делает арену текущей для потока: из неё выделяет ArenaAllocator
+class ArenaScope
+{
+public:
+    explicit ArenaScope(Arena &arena)
+        : previous_(detail::current_arena)
+    {
+        detail::current_arena = &arena;
+    }
+    ~ArenaScope() { detail::current_arena = previous_; }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+    Arena *previous_;
+};
+
+// Аллокатор без состояния поверх текущей арены потока; без арены или при её переполнении -
+// обычный operator new. Объект должен быть разрушен в том же потоке и в пределах того же
+// ArenaScope, что и создан.
+template<typename T>
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &)
+    {}
+
+    T *allocate(std::size_t n)
+    {
+        if (auto *arena = detail::current_arena) {
+            if (void *p = arena->allocate(n * sizeof(T), alignof(T))) {
+                return static_cast<T *>(p);
+            }
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t)
+    {
+        auto *arena = detail::current_arena;
+        if (!arena || !arena->owns(p)) {
+            ::operator delete(p);
+        }
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U> &) const
+    {
+        return true;
+    }
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Base64 (RFC 4648) для передачи двоичных данных внутри JSON
+inline std::string base64Encode(const uint8_t *data, std::size_t size)
+{
+    static constexpr char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string result;
+    result.reserve((size + 2) / 3 * 4);
+    for (std::size_t i = 0; i < size; i += 3) {
+        uint32_t chunk = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < size) {
+            chunk |= static_cast<uint32_t>(data[i + 1]) << 8;
+        }
+        if (i + 2 < size) {
+            chunk |= data[i + 2];
+        }
+        result.push_back(alphabet[(chunk >> 18) & 0x3f]);
+        result.push_back(alphabet[(chunk >> 12) & 0x3f]);
+        result.push_back(i + 1 < size ? alphabet[(chunk >> 6) & 0x3f] : '=');
+        result.push_back(i + 2 < size ? alphabet[chunk & 0x3f] : '=');
+    }
+    return result;
+}
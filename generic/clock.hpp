@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Источник времени приложения. Подменяется SimulatedClock, чтобы прогонять сутки работы
+// за секунды и детерминированно (нагрузочные и длительные прогоны, проверки таймеров).
+class IClock
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    using Duration = std::chrono::steady_clock::duration;
+
+    virtual ~IClock() = default;
+
+    virtual TimePoint now() const = 0;
+    // Календарное время для меток, видимых снаружи (история)
+    virtual std::chrono::system_clock::time_point wallNow() const = 0;
+    virtual void sleepFor(Duration duration) = 0;
+    // false - время идёт только через sleepFor, ждать событий в реальном времени нельзя
+    virtual bool isRealTime() const = 0;
+};
+
+class SystemClock final : public IClock
+{
+public:
+    TimePoint now() const override { return std::chrono::steady_clock::now(); }
+
+    std::chrono::system_clock::time_point wallNow() const override
+    {
+        return std::chrono::system_clock::now();
+    }
+
+    void sleepFor(Duration duration) override { std::this_thread::sleep_for(duration); }
+
+    bool isRealTime() const override { return true; }
+};
+
+// Дискретное время: sleepFor мгновенно сдвигает часы. Читать можно из любого потока,
+// сдвигать - из одного (основной цикл приложения или тест).
+class SimulatedClock final : public IClock
+{
+public:
+    // 2024-01-01 00:00:00 UTC - одинаковые метки истории от прогона к прогону
+    static constexpr std::chrono::system_clock::time_point default_wall_start{
+        std::chrono::seconds(1704067200)};
+
+    explicit SimulatedClock(std::chrono::system_clock::time_point wall_start = default_wall_start)
+        : wall_start_(wall_start)
+    {}
+
+    TimePoint now() const override
+    {
+        return TimePoint(Duration(elapsed_.load(std::memory_order_acquire)));
+    }
+
+    std::chrono::system_clock::time_point wallNow() const override
+    {
+        return wall_start_
+               + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                   Duration(elapsed_.load(std::memory_order_acquire)));
+    }
+
+    void sleepFor(Duration duration) override { advance(duration); }
+
+    bool isRealTime() const override { return false; }
+
+    void advance(Duration duration)
+    {
+        elapsed_.fetch_add(duration.count(), std::memory_order_acq_rel);
+    }
+
+private:
+    std::chrono::system_clock::time_point wall_start_;
+    std::atomic<Duration::rep> elapsed_{0};
+};
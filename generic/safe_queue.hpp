@@ -1,17 +1,29 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <optional>
-#include <queue>
 #include <utility>
+#include <vector>
 
-template<typename T>
+// Очередь на кольцевом буфере: слоты выделяются один раз (или удваиваются при росте
+// неограниченной очереди) и переиспользуются, поэтому push/pop не выделяют память под узлы.
+// tryPushWith/popInto вдобавок сохраняют память самих элементов (буферы строк и т.п.).
+template<typename T, typename Allocator = std::allocator<T>>
 class SafeQueue
 {
 public:
     SafeQueue() = default;
+    // Очередь с ограничением размера: tryPush/tryEmplace отказывают при заполнении.
+    // Все слоты выделяются сразу.
+    explicit SafeQueue(std::size_t capacity, const Allocator &allocator = Allocator())
+        : slots_(capacity, allocator)
+        , capacity_(capacity)
+    {}
     ~SafeQueue() = default;
 
     SafeQueue(const SafeQueue &) = delete;
@@ -20,7 +32,7 @@ public:
     SafeQueue(SafeQueue &&other) noexcept
     {
         std::lock_guard<std::mutex> lock(other.mutex_);
-        queue_ = std::move(other.queue_);
+        moveFrom(other);
     }
 
     SafeQueue &operator=(SafeQueue &&other) noexcept
@@ -28,7 +40,7 @@ public:
         if (this != &other) {
             std::lock_guard<std::mutex> lock_this(mutex_);
             std::lock_guard<std::mutex> lock_other(other.mutex_);
-            queue_ = std::move(other.queue_);
+            moveFrom(other);
         }
         return *this;
     }
@@ -38,7 +50,8 @@ public:
     {
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            queue_.push(item);
+            backSlot() = item;
+            ++count_;
         }
         cond_var_.notify_one();
     }
@@ -48,7 +61,8 @@ public:
     {
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            queue_.push(std::move(item));
+            backSlot() = std::move(item);
+            ++count_;
         }
         cond_var_.notify_one();
     }
@@ -59,40 +73,159 @@ public:
     {
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            queue_.emplace(std::forward<Args>(args)...);
+            backSlot() = T(std::forward<Args>(args)...);
+            ++count_;
         }
         cond_var_.notify_one();
     }
 
+    // Добавить элемент, если не превышен лимит; false - элемент отброшен
+    bool tryPush(T &&item)
+    {
+        return tryPushWith([&item](T &slot) { slot = std::move(item); });
+    }
+
+    template<typename... Args>
+    bool tryEmplace(Args &&...args)
+    {
+        return tryPushWith([&](T &slot) { slot = T(std::forward<Args>(args)...); });
+    }
+
+    // Заполнить свободный слот на месте: fill(T &) получает ранее извлечённый через popInto
+    // объект и может переиспользовать его память, например assign() строк вместо копий.
+    // Вызывается под мьютексом очереди.
+    template<typename Fill>
+    bool tryPushWith(Fill &&fill)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (count_ >= capacity_) {
+                return false;
+            }
+            fill(backSlot());
+            ++count_;
+        }
+        cond_var_.notify_one();
+        return true;
+    }
+
+    // Подготовить все слоты ограниченной очереди, например зарезервировать память строк,
+    // чтобы её не выделял первый tryPushWith в каждый слот
+    template<typename Prepare>
+    void prepareSlots(Prepare &&prepare)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &slot : slots_) {
+            prepare(slot);
+        }
+    }
+
     // Извлечение с таймаутом (в мс)
     std::optional<T> pop(int timeout_ms)
     {
         std::unique_lock<std::mutex> lock(mutex_);
-        if (!cond_var_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] {
-                return !queue_.empty();
-            })) {
+        if (!waitNotEmpty(lock, timeout_ms)) {
             return std::nullopt;
         }
+        return takeFront();
+    }
 
-        T item = std::move(queue_.front());
-        queue_.pop();
-        return item;
+    // Извлечение без ожидания
+    std::optional<T> tryPop()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == 0) {
+            return std::nullopt;
+        }
+        return takeFront();
+    }
+
+    // Извлечение обменом с out: память прежнего значения out остаётся в кольце
+    // и достаётся следующему tryPushWith
+    bool popInto(T &out, int timeout_ms)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!waitNotEmpty(lock, timeout_ms)) {
+            return false;
+        }
+        swapFront(out);
+        return true;
+    }
+
+    bool tryPopInto(T &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == 0) {
+            return false;
+        }
+        swapFront(out);
+        return true;
     }
 
     bool empty() const
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.empty();
+        return count_ == 0;
     }
 
     std::size_t size() const
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.size();
+        return count_;
     }
 
 private:
+    // Слот за последним элементом, при заполненном кольце оно удваивается
+    T &backSlot()
+    {
+        if (count_ == slots_.size()) {
+            static constexpr std::size_t initial_slots = 16;
+            std::vector<T, Allocator> grown(std::max(initial_slots, slots_.size() * 2),
+                                            slots_.get_allocator());
+            for (std::size_t i = 0; i < count_; ++i) {
+                grown[i] = std::move(slots_[(head_ + i) % slots_.size()]);
+            }
+            slots_.swap(grown);
+            head_ = 0;
+        }
+        return slots_[(head_ + count_) % slots_.size()];
+    }
+
+    bool waitNotEmpty(std::unique_lock<std::mutex> &lock, int timeout_ms)
+    {
+        return cond_var_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] {
+            return count_ != 0;
+        });
+    }
+
+    T takeFront()
+    {
+        T item = std::move(slots_[head_]);
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+        return item;
+    }
+
+    void swapFront(T &out)
+    {
+        using std::swap;
+        swap(out, slots_[head_]);
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+    }
+
+    void moveFrom(SafeQueue &other)
+    {
+        slots_ = std::move(other.slots_);
+        head_ = std::exchange(other.head_, 0);
+        count_ = std::exchange(other.count_, 0);
+        capacity_ = other.capacity_;
+    }
+
     mutable std::mutex mutex_;
     std::condition_variable cond_var_;
-    std::queue<T> queue_;
+    std::vector<T, Allocator> slots_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    std::size_t capacity_ = std::numeric_limits<std::size_t>::max();
 };
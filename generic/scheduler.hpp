@@ -0,0 +1,143 @@
+#pragma once
+
+#include "safe_queue.hpp"
+#include "task.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <list>
+#include <queue>
+#include <vector>
+
+namespace async {
+
+// Однопоточный планировщик корутин.
+// post() можно вызывать из любого потока (например, из колбэков mosquitto),
+// остальные методы - только из потока, в котором крутится run()/runOnce().
+class Scheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Scheduler() = default;
+
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    // Поставить корутину в очередь на возобновление
+    void post(std::coroutine_handle<> handle) { ready_.push(handle); }
+
+    // Запустить задачу верхнего уровня, планировщик владеет ей до завершения
+    void spawn(Task<> task)
+    {
+        auto handle = task.handle_;
+        tasks_.push_back(std::move(task));
+        post(handle);
+    }
+
+    // co_await scheduler.sleepFor(...) - приостановка без блокировки потока
+    auto sleepFor(std::chrono::milliseconds duration)
+    {
+        struct SleepAwaiter
+        {
+            Scheduler &scheduler;
+            Clock::time_point deadline;
+
+            bool await_ready() const { return deadline <= Clock::now(); }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                scheduler.timers_.push({deadline, handle});
+            }
+            void await_resume() const noexcept {}
+        };
+        return SleepAwaiter{*this, Clock::now() + duration};
+    }
+
+    // Уступить очередь остальным готовым корутинам
+    auto yield()
+    {
+        struct YieldAwaiter
+        {
+            Scheduler &scheduler;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler.post(handle); }
+            void await_resume() const noexcept {}
+        };
+        return YieldAwaiter{*this};
+    }
+
+    // Обработать одно событие, ожидая его не дольше max_wait_ms.
+    // Исключение из завершившейся задачи верхнего уровня пробрасывается наружу.
+    void runOnce(int max_wait_ms)
+    {
+        auto now = Clock::now();
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            auto handle = timers_.top().handle;
+            timers_.pop();
+            handle.resume();
+        }
+
+        int wait_ms = max_wait_ms;
+        if (!timers_.empty()) {
+            auto until_timer = std::chrono::duration_cast<std::chrono::milliseconds>(
+                timers_.top().deadline - now);
+            wait_ms = std::clamp(static_cast<int>(until_timer.count()), 0, max_wait_ms);
+        }
+
+        if (auto handle = ready_.pop(wait_ms)) {
+            handle->resume();
+        }
+
+        reapFinishedTasks();
+    }
+
+    void run()
+    {
+        static constexpr int idle_wait_ms = 100;
+
+        stopped_ = false;
+        while (!stopped_ && (!tasks_.empty() || !timers_.empty() || !ready_.empty())) {
+            runOnce(idle_wait_ms);
+        }
+    }
+
+    // Можно вызывать из любого потока
+    void stop()
+    {
+        stopped_ = true;
+        post(std::noop_coroutine());
+    }
+
+private:
+    struct Timer
+    {
+        Clock::time_point deadline;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer &other) const { return deadline > other.deadline; }
+    };
+
+    void reapFinishedTasks()
+    {
+        for (auto it = tasks_.begin(); it != tasks_.end();) {
+            if (!it->done()) {
+                ++it;
+                continue;
+            }
+            Task<> finished = std::move(*it);
+            it = tasks_.erase(it);
+            finished.handle_.promise().rethrowIfFailed();
+        }
+    }
+
+    SafeQueue<std::coroutine_handle<>> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::list<Task<>> tasks_;
+    std::atomic<bool> stopped_{false};
+};
+
+} // namespace async
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+// Ограничитель частоты "token bucket": rate_per_s токенов в секунду, не более burst подряд.
+// Не потокобезопасен, используется из одного потока.
+class TokenBucket
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket(double rate_per_s, double burst, Clock::time_point now = Clock::now())
+        : rate_per_s_(rate_per_s)
+        , burst_(burst)
+        , tokens_(burst)
+        , last_refill_(now)
+    {}
+
+    bool tryConsume(Clock::time_point now = Clock::now())
+    {
+        refill(now);
+        if (tokens_ < 1.0) {
+            return false;
+        }
+        tokens_ -= 1.0;
+        return true;
+    }
+
+private:
+    void refill(Clock::time_point now)
+    {
+        if (now <= last_refill_) {
+            return;
+        }
+        std::chrono::duration<double> elapsed = now - last_refill_;
+        tokens_ = std::min(burst_, tokens_ + elapsed.count() * rate_per_s_);
+        last_refill_ = now;
+    }
+
+    double rate_per_s_;
+    double burst_;
+    double tokens_;
+    Clock::time_point last_refill_;
+};
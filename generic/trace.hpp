@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Трассировка задержек обработки команд. Интервал (span) пишется в кольцевой буфер
+// своего потока без блокировок; выгрузка - в формате Chrome trace (chrome://tracing,
+// ui.perfetto.dev). Интервалы одной команды связаны id трассы, который передаётся
+// между потоками вместе с сообщением, а внутри потока хранится как текущий (Context).
+// Выключена по умолчанию: тогда запись - одна relaxed-загрузка флага.
+namespace trace {
+
+struct Span
+{
+    // Только строковые литералы: имя не копируется
+    const char *name;
+    uint64_t id;
+    int64_t start_ns;
+    int64_t end_ns;
+};
+
+inline int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Буфер одного потока: пишет только владелец, читает выгрузка из любого потока.
+// Каждый слот - seqlock из атомарных полей: читатель не видит наполовину записанный интервал
+// и отбрасывает слот, перезаписанный во время копирования.
+class Buffer
+{
+public:
+    static constexpr std::size_t capacity = 4096;
+
+    explicit Buffer(uint32_t thread_index)
+        : thread_index_(thread_index)
+    {}
+
+    uint32_t threadIndex() const { return thread_index_; }
+
+    void push(const Span &span)
+    {
+        const uint64_t index = written_.load(std::memory_order_relaxed);
+        Slot &slot = slots_[index % capacity];
+        // Нечётное значение - слот пишется, 2 * (index + 1) - в слоте интервал номер index
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(span.name, std::memory_order_relaxed);
+        slot.id.store(span.id, std::memory_order_relaxed);
+        slot.start_ns.store(span.start_ns, std::memory_order_relaxed);
+        slot.end_ns.store(span.end_ns, std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        written_.store(index + 1, std::memory_order_release);
+    }
+
+    // Последние не более capacity интервалов
+    std::vector<Span> snapshot() const
+    {
+        const uint64_t end = written_.load(std::memory_order_acquire);
+        const uint64_t begin = end > capacity ? end - capacity : 0;
+
+        std::vector<Span> spans;
+        spans.reserve(end - begin);
+        for (uint64_t index = begin; index < end; ++index) {
+            const Slot &slot = slots_[index % capacity];
+            const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * index + 2) {
+                continue;
+            }
+            Span span{slot.name.load(std::memory_order_relaxed),
+                      slot.id.load(std::memory_order_relaxed),
+                      slot.start_ns.load(std::memory_order_relaxed),
+                      slot.end_ns.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+                spans.push_back(span);
+            }
+        }
+        return spans;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<const char *> name{nullptr};
+        std::atomic<uint64_t> id{0};
+        std::atomic<int64_t> start_ns{0};
+        std::atomic<int64_t> end_ns{0};
+    };
+
+    uint32_t thread_index_;
+    std::atomic<uint64_t> written_{0};
+    Slot slots_[capacity];
+};
+
+namespace detail {
+
+struct Registry
+{
+    std::atomic<bool> enabled{false};
+    std::atomic<uint64_t> next_id{1};
+    std::mutex mutex;
+    // Буферы переживают свои потоки, чтобы их интервалы попали в выгрузку
+    std::vector<std::shared_ptr<Buffer>> buffers;
+};
+
+inline Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+inline Buffer &localBuffer()
+{
+    // Мьютекс берётся один раз на поток - при первой записи
+    thread_local std::shared_ptr<Buffer> buffer = [] {
+        auto &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto created = std::make_shared<Buffer>(static_cast<uint32_t>(r.buffers.size() + 1));
+        r.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+inline thread_local uint64_t current_id = 0;
+
+} // namespace detail
+
+inline void enable(bool on)
+{
+    detail::registry().enabled.store(on, std::memory_order_relaxed);
+}
+
+inline bool enabled()
+{
+    return detail::registry().enabled.load(std::memory_order_relaxed);
+}
+
+// Новый id трассы, 0 - трассировка выключена
+inline uint64_t newId()
+{
+    return enabled() ? detail::registry().next_id.fetch_add(1, std::memory_order_relaxed) : 0;
+}
+
+inline uint64_t currentId()
+{
+    return detail::current_id;
+}
+
+inline void record(const char *name, uint64_t id, int64_t start_ns, int64_t end_ns)
+{
+    if (enabled()) {
+        detail::localBuffer().push({name, id, start_ns, end_ns});
+    }
+}
+
+// Делает id текущим для потока на время жизни объекта
+class Context
+{
+public:
+    explicit Context(uint64_t id)
+        : previous_(detail::current_id)
+    {
+        detail::current_id = id;
+    }
+    ~Context() { detail::current_id = previous_; }
+
+    Context(const Context &) = delete;
+    Context &operator=(const Context &) = delete;
+
+private:
+    uint64_t previous_;
+};
+
+// Интервал от создания до разрушения объекта, с текущим id трассы
+class Scope
+{
+public:
+    explicit Scope(const char *name)
+        : name_(name)
+        , id_(detail::current_id)
+        , start_ns_(enabled() ? nowNs() : 0)
+    {}
+    ~Scope()
+    {
+        if (start_ns_ != 0) {
+            record(name_, id_, start_ns_, nowNs());
+        }
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *name_;
+    uint64_t id_;
+    int64_t start_ns_;
+};
+
+struct Thread
+{
+    uint32_t index;
+    std::vector<Span> spans;
+};
+
+inline std::vector<Thread> collect()
+{
+    auto &r = detail::registry();
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        buffers = r.buffers;
+    }
+
+    std::vector<Thread> threads;
+    for (const auto &buffer : buffers) {
+        threads.push_back({buffer->threadIndex(), buffer->snapshot()});
+    }
+    return threads;
+}
+
+struct Stats
+{
+    std::string name;
+    std::size_t count;
+    double p50_us;
+    double p90_us;
+    double p99_us;
+    double max_us;
+};
+
+// Перцентили длительности по именам интервалов и "command.total" - от начала первого
+// до конца последнего интервала каждой трассы (приём команды -> публикация результата)
+inline std::vector<Stats> summarize(const std::vector<Thread> &threads)
+{
+    std::map<std::string, std::vector<int64_t>> durations;
+    std::map<uint64_t, std::pair<int64_t, int64_t>> traces;
+    for (const auto &thread : threads) {
+        for (const auto &span : thread.spans) {
+            durations[span.name].push_back(span.end_ns - span.start_ns);
+            if (span.id == 0) {
+                continue;
+            }
+            auto [it, inserted] = traces.try_emplace(span.id, span.start_ns, span.end_ns);
+            if (!inserted) {
+                it->second.first = std::min(it->second.first, span.start_ns);
+                it->second.second = std::max(it->second.second, span.end_ns);
+            }
+        }
+    }
+    for (const auto &[id, bounds] : traces) {
+        durations["command.total"].push_back(bounds.second - bounds.first);
+    }
+
+    std::vector<Stats> stats;
+    for (auto &[name, values] : durations) {
+        std::sort(values.begin(), values.end());
+        auto percentile = [&values](double p) {
+            auto index = static_cast<std::size_t>(p * static_cast<double>(values.size() - 1));
+            return static_cast<double>(values[index]) / 1000.0;
+        };
+        stats.push_back({name,
+                         values.size(),
+                         percentile(0.5),
+                         percentile(0.9),
+                         percentile(0.99),
+                         static_cast<double>(values.back()) / 1000.0});
+    }
+    return stats;
+}
+
+// Chrome trace JSON: интервалы - события "X", сводка - в otherData
+inline void writeChromeTrace(std::ostream &out, const std::vector<Thread> &threads)
+{
+    auto microseconds = [](int64_t ns) {
+        return std::to_string(ns / 1000) + "." + std::to_string(1000 + ns % 1000).substr(1);
+    };
+
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto &thread : threads) {
+        for (const auto &span : thread.spans) {
+            out << (first ? "" : ",") << "\n{\"name\":\"" << span.name
+                << "\",\"cat\":\"command\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.index
+                << ",\"ts\":" << microseconds(span.start_ns)
+                << ",\"dur\":" << microseconds(span.end_ns - span.start_ns)
+                << ",\"args\":{\"id\":" << span.id << "}}";
+            first = false;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"summary\":[";
+    first = true;
+    for (const auto &s : summarize(threads)) {
+        out << (first ? "" : ",") << "\n{\"name\":\"" << s.name << "\",\"count\":" << s.count
+            << ",\"p50_us\":" << s.p50_us << ",\"p90_us\":" << s.p90_us
+            << ",\"p99_us\":" << s.p99_us << ",\"max_us\":" << s.max_us << "}";
+        first = false;
+    }
+    out << "\n]}}\n";
+}
+
+} // namespace trace
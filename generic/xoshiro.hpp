@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// xoshiro256+ (Blackman, Vigna): быстрый генератор для вещественных чисел,
+// старшие 53 бита результата равномерны. Не криптостойкий.
+namespace xoshiro {
+
+inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+// Инициализация состояния из одного числа, как рекомендуют авторы
+inline uint64_t splitmix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// [0, 1) из старших 53 бит
+inline double toUnit(uint64_t x)
+{
+    return static_cast<double>(x >> 11) * 0x1.0p-53;
+}
+
+// Много независимых потоков в раскладке "структура массивов": шаг всех потоков - один цикл
+// без ветвлений и зависимостей между итерациями, который компилятор векторизует.
+class Streams
+{
+public:
+    Streams(std::size_t count, uint64_t seed)
+        : s0_(count)
+        , s1_(count)
+        , s2_(count)
+        , s3_(count)
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            s0_[i] = splitmix64(seed);
+            s1_[i] = splitmix64(seed);
+            s2_[i] = splitmix64(seed);
+            s3_[i] = splitmix64(seed);
+        }
+    }
+
+    std::size_t size() const { return s0_.size(); }
+
+    // По одному числу каждого потока в out[0..size())
+    void next(uint64_t *__restrict out)
+    {
+        const std::size_t count = s0_.size();
+        uint64_t *__restrict s0 = s0_.data();
+        uint64_t *__restrict s1 = s1_.data();
+        uint64_t *__restrict s2 = s2_.data();
+        uint64_t *__restrict s3 = s3_.data();
+
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = s0[i] + s3[i];
+
+            const uint64_t t = s1[i] << 17;
+            s2[i] ^= s0[i];
+            s3[i] ^= s1[i];
+            s1[i] ^= s2[i];
+            s0[i] ^= s3[i];
+            s2[i] ^= t;
+            s3[i] = rotl(s3[i], 45);
+        }
+    }
+
+private:
+    std::vector<uint64_t> s0_;
+    std::vector<uint64_t> s1_;
+    std::vector<uint64_t> s2_;
+    std::vector<uint64_t> s3_;
+};
+
+} // namespace xoshiro
@@ -3,7 +3,9 @@
 #include "gpio_types.hpp"
 #include <stdint.h>
 
+#include <chrono>
 #include <functional>
+#include <vector>
 
 namespace gpio {
 
@@ -18,10 +20,38 @@ public:
     virtual void writeDigitalPin(int pin_number, gpio::DigitalValue value) = 0;
     virtual void writeAnalogPin(int pin_number, uint8_t value) = 0;
 
+    // Плавный переход аналогового выхода к target за duration с фиксированным шагом таймера.
+    // Промежуточные значения не вызывают WriteAnalogCallback, финальное - вызывает.
+    // Обычная запись в пин или новый переход отменяют текущий.
+    virtual void fadeAnalogPin(int pin_number,
+                               uint8_t target,
+                               std::chrono::milliseconds duration,
+                               gpio::Easing easing) = 0;
+
     virtual gpio::DigitalValue readDigitalPin(int pin_number) = 0;
     virtual uint8_t readAnalogPin(int pin_number) = 0;
 
+    // Состояние всех зарегистрированных пинов, упорядоченное по номеру
+    std::vector<gpio::PinSnapshot> snapshot()
+    {
+        std::vector<gpio::PinSnapshot> pins;
+        snapshotInto(pins);
+        return pins;
+    }
+    // То же в pins: при достаточной ёмкости вектора память не выделяется
+    virtual void snapshotInto(std::vector<gpio::PinSnapshot> &pins) = 0;
+
     virtual void injectAnalogValue(int pin_number, uint8_t value) = 0;
+    virtual void injectDigitalValue(int pin_number, gpio::DigitalValue value) = 0;
+
+    // Колбэк по фронту цифрового входа (аналог прерывания): вызывается из потока,
+    // выполнившего injectDigitalValue, вне внутренней блокировки и только на переходах,
+    // отстоящих от предыдущего принятого перехода не меньше чем на debounce. Уровень входа
+    // обновляется и при переходах внутри окна
+    virtual void setEdgeCallback(int pin_number,
+                                 gpio::EdgeMode mode,
+                                 std::chrono::milliseconds debounce,
+                                 std::function<void(int, gpio::DigitalValue)> callback) = 0;
 
     virtual void setWriteDigitalCallback(std::function<void(int, gpio::DigitalValue)> callback) = 0;
     virtual void setWriteAnalogCallback(std::function<void(int, uint8_t)> callback) = 0;
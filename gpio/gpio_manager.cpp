@@ -1,28 +1,71 @@
 #include "gpio_manager.hpp"
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
+#include <utility>
 
 namespace gpio {
 
+namespace {
+
+double applyEasing(Easing easing, double t)
+{
+    switch (easing) {
+    case Easing::EaseIn:
+        return t * t;
+    case Easing::EaseOut:
+        return 1.0 - (1.0 - t) * (1.0 - t);
+    case Easing::EaseInOut:
+        return t < 0.5 ? 2.0 * t * t : 1.0 - 2.0 * (1.0 - t) * (1.0 - t);
+    case Easing::Linear:
+    default:
+        return t;
+    }
+}
+
+} // namespace
+
 Manager::Manager() = default;
-Manager::~Manager() = default;
 
+Manager::~Manager()
+{
+    stopFadeThread();
+}
+
+// Поток переходов привязан к this, поэтому у источника он останавливается,
+// а у нового владельца поднимается заново, если переходы ещё не завершены
 Manager::Manager(Manager &&other) noexcept
 {
+    other.stopFadeThread();
+
     std::lock_guard<std::mutex> lock(other.mutex_);
     pins_ = std::move(other.pins_);
     writeDigitalCallback_ = std::move(other.writeDigitalCallback_);
     writeAnalogCallback_ = std::move(other.writeAnalogCallback_);
+    shm_exporter_ = std::move(other.shm_exporter_);
+    active_fades_ = std::exchange(other.active_fades_, 0);
+    if (active_fades_ > 0) {
+        fade_thread_ = std::thread([this] { fadeLoop(); });
+    }
 }
 
 Manager &Manager::operator=(Manager &&other) noexcept
 {
     if (this != &other) {
+        stopFadeThread();
+        other.stopFadeThread();
         {
             std::lock_guard<std::mutex> lock_this(mutex_);
             std::lock_guard<std::mutex> lock_other(other.mutex_);
             pins_ = std::move(other.pins_);
             writeDigitalCallback_ = std::move(other.writeDigitalCallback_);
             writeAnalogCallback_ = std::move(other.writeAnalogCallback_);
+            shm_exporter_ = std::move(other.shm_exporter_);
+            active_fades_ = std::exchange(other.active_fades_, 0);
+            fade_stop_ = false;
+            if (active_fades_ > 0) {
+                fade_thread_ = std::thread([this] { fadeLoop(); });
+            }
         }
     }
     return *this;
@@ -35,6 +78,7 @@ void Manager::registerPin(const PinConfig &config)
     if (!inserted) {
         throw std::runtime_error("Pin already registered: " + std::to_string(config.number));
     }
+    mirrorState();
 }
 
 void Manager::unregisterPin(int pin_number)
@@ -44,7 +88,9 @@ void Manager::unregisterPin(int pin_number)
     if (it == pins_.end()) {
         throw std::runtime_error("Pin not registered: " + std::to_string(pin_number));
     }
+    cancelFade(it->second);
     pins_.erase(it);
+    mirrorState();
 }
 
 void Manager::writeDigitalPin(int pin_number, DigitalValue value)
@@ -60,6 +106,7 @@ void Manager::writeDigitalPin(int pin_number, DigitalValue value)
     }
 
     it->second.value = static_cast<uint8_t>((value == DigitalValue::High) ? 1 : 0);
+    mirrorState();
     triggerWriteDigitalCallback(pin_number, value);
 }
 
@@ -75,10 +122,47 @@ void Manager::writeAnalogPin(int pin_number, uint8_t value)
                                  + std::to_string(pin_number));
     }
 
+    cancelFade(it->second);
     it->second.value = value;
+    mirrorState();
     triggerWriteAnalogCallback(pin_number, value);
 }
 
+void Manager::fadeAnalogPin(int pin_number,
+                            uint8_t target,
+                            std::chrono::milliseconds duration,
+                            Easing easing)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pins_.find(pin_number);
+    if (it == pins_.end()) {
+        throw std::runtime_error("Pin not registered: " + std::to_string(pin_number));
+    }
+    if (it->second.mode != PinMode::Output || it->second.type != PinType::Analog) {
+        throw std::runtime_error("Attempt to write to non-analog output pin: "
+                                 + std::to_string(pin_number));
+    }
+
+    auto &state = it->second;
+    cancelFade(state);
+
+    if (duration <= std::chrono::milliseconds::zero()) {
+        state.value = target;
+        mirrorState();
+        triggerWriteAnalogCallback(pin_number, target);
+        return;
+    }
+
+    state.fade = Fade{state.value, target, std::chrono::steady_clock::now(), duration, easing};
+    ++active_fades_;
+
+    if (!fade_thread_.joinable()) {
+        fade_stop_ = false;
+        fade_thread_ = std::thread([this] { fadeLoop(); });
+    }
+    fade_cv_.notify_one();
+}
+
 DigitalValue Manager::readDigitalPin(int pin_number)
 {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -107,6 +191,22 @@ uint8_t Manager::readAnalogPin(int pin_number)
     return it->second.value;
 }
 
+void Manager::snapshotInto(std::vector<PinSnapshot> &pins)
+{
+    pins.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pins.reserve(pins_.size());
+        for (const auto &[number, state] : pins_) {
+            pins.push_back({number, state.type, state.mode, state.value});
+        }
+    }
+
+    std::sort(pins.begin(), pins.end(), [](const PinSnapshot &a, const PinSnapshot &b) {
+        return a.number < b.number;
+    });
+}
+
 void Manager::setWriteDigitalCallback(WriteDigitalCallback cb)
 {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -147,6 +247,156 @@ void Manager::injectAnalogValue(int pin_number, uint8_t value)
     }
 
     state.value = value;
+    mirrorState();
+}
+
+void Manager::injectDigitalValue(int pin_number, DigitalValue value)
+{
+    EdgeCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pins_.find(pin_number);
+        if (it == pins_.end()) {
+            throw std::runtime_error("Pin not registered: " + std::to_string(pin_number));
+        }
+
+        auto &state = it->second;
+        if (state.type != PinType::Digital || state.mode != PinMode::Input) {
+            throw std::runtime_error("Pin is not digital input: " + std::to_string(pin_number));
+        }
+
+        const uint8_t level = (value == DigitalValue::High) ? 1 : 0;
+        if (state.value == level) {
+            return;
+        }
+
+        // Уровень пина меняется всегда, антидребезг подавляет только колбэк. Иначе после
+        // отброшенного отпускания пин оставался бы нажатым и следующее нажатие терялось.
+        state.value = level;
+        mirrorState();
+
+        auto now = std::chrono::steady_clock::now();
+        auto &edge = state.edge;
+        if (edge.last_edge != std::chrono::steady_clock::time_point{}
+            && now - edge.last_edge < edge.debounce) {
+            return;
+        }
+        edge.last_edge = now;
+
+        const bool rising = value == DigitalValue::High;
+        if (edge.callback
+            && (edge.mode == EdgeMode::Both || (edge.mode == EdgeMode::Rising) == rising)) {
+            callback = edge.callback;
+        }
+    }
+
+    if (callback) {
+        callback(pin_number, value);
+    }
+}
+
+void Manager::setEdgeCallback(int pin_number,
+                              EdgeMode mode,
+                              std::chrono::milliseconds debounce,
+                              EdgeCallback callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pins_.find(pin_number);
+    if (it == pins_.end()) {
+        throw std::runtime_error("Pin not registered: " + std::to_string(pin_number));
+    }
+
+    auto &state = it->second;
+    if (state.type != PinType::Digital || state.mode != PinMode::Input) {
+        throw std::runtime_error("Pin is not digital input: " + std::to_string(pin_number));
+    }
+
+    state.edge.mode = mode;
+    state.edge.debounce = debounce;
+    state.edge.callback = std::move(callback);
+}
+
+void Manager::fadeLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto next_tick = std::chrono::steady_clock::now();
+
+    while (!fade_stop_) {
+        if (active_fades_ == 0) {
+            fade_cv_.wait(lock, [this] { return fade_stop_ || active_fades_ > 0; });
+            next_tick = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        // Шаг отсчитывается от расписания, а не от момента пробуждения, чтобы частота не плыла
+        next_tick += fade_tick;
+        if (fade_cv_.wait_until(lock, next_tick, [this] { return fade_stop_; })) {
+            break;
+        }
+        tickFades(std::chrono::steady_clock::now());
+    }
+}
+
+void Manager::tickFades(std::chrono::steady_clock::time_point now)
+{
+    for (auto &[pin_number, state] : pins_) {
+        if (!state.fade) {
+            continue;
+        }
+
+        const auto &fade = *state.fade;
+        const double t = std::min(1.0,
+                                  std::chrono::duration<double>(now - fade.start)
+                                      / std::chrono::duration<double>(fade.duration));
+        const double eased = applyEasing(fade.easing, t);
+        state.value = static_cast<uint8_t>(
+            std::lround(fade.from + (static_cast<int>(fade.to) - fade.from) * eased));
+
+        if (t >= 1.0) {
+            state.value = fade.to;
+            cancelFade(state);
+            triggerWriteAnalogCallback(pin_number, state.value);
+        }
+    }
+
+    // Промежуточные значения не уходят в колбэки записи, но видны локальным наблюдателям
+    mirrorState();
+}
+
+void Manager::cancelFade(PinState &state)
+{
+    if (state.fade) {
+        state.fade.reset();
+        --active_fades_;
+    }
+}
+
+void Manager::exportStateToSharedMemory(const std::string &shm_name)
+{
+    auto exporter = std::make_unique<ShmStateExporter>(shm_name);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    shm_exporter_ = std::move(exporter);
+    mirrorState();
+}
+
+void Manager::mirrorState()
+{
+    if (shm_exporter_) {
+        shm_exporter_->publish(pins_);
+    }
+}
+
+void Manager::stopFadeThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fade_stop_ = true;
+    }
+    fade_cv_.notify_all();
+    if (fade_thread_.joinable()) {
+        fade_thread_.join();
+    }
 }
 
 } // namespace gpio
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "gpio_imanager.hpp"
+#include "gpio_shm_exporter.hpp"
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
 #include <unordered_map>
 
 namespace gpio {
@@ -13,6 +20,10 @@ class Manager : public IManager
 public:
     using WriteDigitalCallback = std::function<void(int pin_number, DigitalValue value)>;
     using WriteAnalogCallback = std::function<void(int pin_number, uint8_t value)>;
+    using EdgeCallback = std::function<void(int pin_number, DigitalValue value)>;
+
+    // Шаг таймера плавных переходов (50 Гц)
+    static constexpr std::chrono::milliseconds fade_tick{20};
 
     Manager();
     ~Manager();
@@ -28,20 +39,56 @@ public:
     void writeDigitalPin(int pin_number, DigitalValue value) override final;
     void writeAnalogPin(int pin_number, uint8_t value) override final;
 
+    void fadeAnalogPin(int pin_number,
+                       uint8_t target,
+                       std::chrono::milliseconds duration,
+                       Easing easing) override final;
+
     DigitalValue readDigitalPin(int pin_number) override final;
     uint8_t readAnalogPin(int pin_number) override final;
 
+    void snapshotInto(std::vector<PinSnapshot> &pins) override final;
+
     void setWriteDigitalCallback(WriteDigitalCallback cb) override final;
     void setWriteAnalogCallback(WriteAnalogCallback cb) override final;
 
     void injectAnalogValue(int pin_number, uint8_t value) override final;
+    void injectDigitalValue(int pin_number, DigitalValue value) override final;
+
+    void setEdgeCallback(int pin_number,
+                         EdgeMode mode,
+                         std::chrono::milliseconds debounce,
+                         EdgeCallback callback) override final;
+
+    // Зеркалировать таблицу пинов в POSIX shared memory (seqlock) для локальных
+    // наблюдателей, см. gpio::ShmStateReader. Бросает исключение, если сегмент не создан.
+    void exportStateToSharedMemory(const std::string &shm_name);
 
 private:
+    struct EdgeDetector
+    {
+        EdgeMode mode = EdgeMode::Both;
+        std::chrono::milliseconds debounce{0};
+        std::chrono::steady_clock::time_point last_edge{};
+        EdgeCallback callback;
+    };
+
+    struct Fade
+    {
+        uint8_t from;
+        uint8_t to;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::milliseconds duration;
+        Easing easing;
+    };
+
     struct PinState
     {
         PinType type;
         PinMode mode;
         uint8_t value;
+        EdgeDetector edge{};
+        std::optional<Fade> fade{};
     };
 
     mutable std::mutex mutex_;
@@ -49,8 +96,23 @@ private:
     WriteDigitalCallback writeDigitalCallback_;
     WriteAnalogCallback writeAnalogCallback_;
 
+    // Поток плавных переходов запускается при первом fadeAnalogPin и спит, пока переходов нет
+    std::thread fade_thread_;
+    std::condition_variable fade_cv_;
+    std::size_t active_fades_ = 0;
+    bool fade_stop_ = false;
+
+    std::unique_ptr<ShmStateExporter> shm_exporter_;
+
     void triggerWriteDigitalCallback(int pin_number, DigitalValue value);
     void triggerWriteAnalogCallback(int pin_number, uint8_t value);
+
+    void fadeLoop();
+    void tickFades(std::chrono::steady_clock::time_point now);
+    void cancelFade(PinState &state);
+    void stopFadeThread();
+    // Вызывается под mutex_ после каждого изменения таблицы пинов
+    void mirrorState();
 };
 
 } // namespace gpio
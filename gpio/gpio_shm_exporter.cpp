@@ -0,0 +1,67 @@
+#include "gpio_shm_exporter.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace gpio {
+
+ShmStateExporter::ShmStateExporter(const std::string &name)
+    : name_(name)
+{
+    fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("shm_open failed for " + name_ + ": " + std::strerror(errno));
+    }
+
+    if (ftruncate(fd_, sizeof(shm::Segment)) != 0) {
+        int err = errno;
+        close(fd_);
+        shm_unlink(name_.c_str());
+        throw std::runtime_error("ftruncate failed for " + name_ + ": " + std::strerror(err));
+    }
+
+    void *addr = mmap(nullptr, sizeof(shm::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        int err = errno;
+        close(fd_);
+        shm_unlink(name_.c_str());
+        throw std::runtime_error("mmap failed for " + name_ + ": " + std::strerror(err));
+    }
+
+    segment_ = static_cast<shm::Segment *>(addr);
+    segment_->sequence.store(0, std::memory_order_relaxed);
+    segment_->pin_count.store(0, std::memory_order_relaxed);
+    segment_->version.store(shm::version, std::memory_order_relaxed);
+    // magic пишется последним: читатель не примет сегмент до конца инициализации
+    segment_->magic.store(shm::magic, std::memory_order_release);
+}
+
+ShmStateExporter::~ShmStateExporter()
+{
+    if (segment_) {
+        munmap(segment_, sizeof(shm::Segment));
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        shm_unlink(name_.c_str());
+    }
+}
+
+void ShmStateExporter::beginWrite()
+{
+    auto sequence = segment_->sequence.load(std::memory_order_relaxed);
+    segment_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ShmStateExporter::endWrite()
+{
+    auto sequence = segment_->sequence.load(std::memory_order_relaxed);
+    segment_->sequence.store(sequence + 1, std::memory_order_release);
+}
+
+} // namespace gpio
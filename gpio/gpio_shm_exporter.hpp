@@ -0,0 +1,49 @@
+#pragma once
+
+#include "gpio_shm_layout.hpp"
+
+#include <string>
+
+namespace gpio {
+
+// Владелец сегмента POSIX shared memory с зеркалом таблицы пинов.
+// Один писатель; синхронизацию между потоками писателя обеспечивает вызывающий.
+class ShmStateExporter
+{
+public:
+    // name в формате shm_open, например "/embedded_gpio"
+    explicit ShmStateExporter(const std::string &name);
+    ~ShmStateExporter();
+
+    ShmStateExporter(const ShmStateExporter &) = delete;
+    ShmStateExporter &operator=(const ShmStateExporter &) = delete;
+
+    // Публикует полную таблицу пинов одной seqlock-транзакцией.
+    // Range - любой контейнер пар (номер пина, состояние) с полями type/mode/value.
+    template<typename Range>
+    void publish(const Range &pins)
+    {
+        beginWrite();
+        uint32_t count = 0;
+        for (const auto &[number, state] : pins) {
+            if (count == shm::max_pins) {
+                break;
+            }
+            segment_->pins[count++].store(
+                shm::pack(PinSnapshot{number, state.type, state.mode, state.value}),
+                std::memory_order_relaxed);
+        }
+        segment_->pin_count.store(count, std::memory_order_relaxed);
+        endWrite();
+    }
+
+private:
+    void beginWrite();
+    void endWrite();
+
+    std::string name_;
+    int fd_ = -1;
+    shm::Segment *segment_ = nullptr;
+};
+
+} // namespace gpio
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "gpio_types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Раскладка сегмента разделяемой памяти с таблицей пинов.
+// Общая для писателя (gpio::Manager) и читателей в других процессах, поэтому
+// содержит только lock-free атомики фиксированного размера.
+namespace gpio::shm {
+
+inline constexpr uint32_t magic = 0x4F495047; // "GPIO"
+inline constexpr uint32_t version = 1;
+inline constexpr std::size_t max_pins = 64;
+
+// Seqlock: писатель делает sequence нечётным на время записи и чётным после.
+// Читатель повторяет чтение, пока не получит одинаковое чётное значение до и после.
+struct Segment
+{
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> version;
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> pin_count;
+    // Каждая запись пина упакована в одно слово, см. pack()/unpack()
+    std::atomic<uint64_t> pins[max_pins];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+inline uint64_t pack(const PinSnapshot &pin)
+{
+    return static_cast<uint64_t>(static_cast<uint32_t>(pin.number))
+           | static_cast<uint64_t>(pin.type) << 32 | static_cast<uint64_t>(pin.mode) << 40
+           | static_cast<uint64_t>(pin.value) << 48;
+}
+
+inline PinSnapshot unpack(uint64_t word)
+{
+    return PinSnapshot{static_cast<int>(static_cast<uint32_t>(word)),
+                       static_cast<PinType>((word >> 32) & 0xFF),
+                       static_cast<PinMode>((word >> 40) & 0xFF),
+                       static_cast<uint8_t>((word >> 48) & 0xFF)};
+}
+
+} // namespace gpio::shm
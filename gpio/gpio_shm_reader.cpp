@@ -0,0 +1,94 @@
+#include "gpio_shm_reader.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+namespace gpio {
+
+ShmStateReader::ShmStateReader(const std::string &name)
+{
+    fd_ = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd_ < 0) {
+        throw std::runtime_error("shm_open failed for " + name + ": " + std::strerror(errno));
+    }
+
+    void *addr = mmap(nullptr, sizeof(shm::Segment), PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        int err = errno;
+        close(fd_);
+        throw std::runtime_error("mmap failed for " + name + ": " + std::strerror(err));
+    }
+    segment_ = static_cast<const shm::Segment *>(addr);
+
+    if (segment_->magic.load(std::memory_order_acquire) != shm::magic
+        || segment_->version.load(std::memory_order_relaxed) != shm::version) {
+        munmap(const_cast<shm::Segment *>(segment_), sizeof(shm::Segment));
+        close(fd_);
+        throw std::runtime_error("Unsupported GPIO shared memory segment: " + name);
+    }
+}
+
+ShmStateReader::~ShmStateReader()
+{
+    munmap(const_cast<shm::Segment *>(segment_), sizeof(shm::Segment));
+    close(fd_);
+}
+
+bool ShmStateReader::read(Snapshot &snapshot, std::chrono::microseconds timeout) const
+{
+    // Часы опрашиваются только после неудачной попытки: свободный сегмент читается сразу
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    for (;;) {
+        uint32_t begin = segment_->sequence.load(std::memory_order_acquire);
+        if ((begin & 1) == 0) {
+            std::size_t count = segment_->pin_count.load(std::memory_order_relaxed);
+            if (count > shm::max_pins) {
+                count = shm::max_pins;
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                snapshot.pins[i] = shm::unpack(segment_->pins[i].load(std::memory_order_relaxed));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (segment_->sequence.load(std::memory_order_relaxed) == begin) {
+                snapshot.sequence = begin;
+                snapshot.count = count;
+                return true;
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!deadline) {
+            deadline = now + timeout;
+        } else if (now >= *deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+}
+
+std::optional<PinSnapshot> ShmStateReader::readPin(int pin_number) const
+{
+    Snapshot snapshot;
+    if (!read(snapshot)) {
+        return std::nullopt;
+    }
+    for (std::size_t i = 0; i < snapshot.count; ++i) {
+        if (snapshot.pins[i].number == pin_number) {
+            return snapshot.pins[i];
+        }
+    }
+    return std::nullopt;
+}
+
+uint32_t ShmStateReader::sequence() const
+{
+    return segment_->sequence.load(std::memory_order_acquire);
+}
+
+} // namespace gpio
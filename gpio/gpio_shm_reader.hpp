@@ -0,0 +1,48 @@
+#pragma once
+
+#include "gpio_shm_layout.hpp"
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace gpio {
+
+// Читатель зеркала таблицы пинов для локальных процессов (например, дашборда).
+// Не блокирует писателя и не выделяет память при чтении.
+class ShmStateReader
+{
+public:
+    struct Snapshot
+    {
+        uint32_t sequence = 0;
+        std::size_t count = 0;
+        std::array<PinSnapshot, shm::max_pins> pins{};
+    };
+
+    // Запись писателя занимает микросекунды
+    static constexpr std::chrono::microseconds default_read_timeout{10000};
+
+    explicit ShmStateReader(const std::string &name);
+    ~ShmStateReader();
+
+    ShmStateReader(const ShmStateReader &) = delete;
+    ShmStateReader &operator=(const ShmStateReader &) = delete;
+
+    // Согласованный снимок всех пинов. false - за timeout снять его не удалось: писатель
+    // завис или завершился посреди записи (нечётный sequence) либо пишет без перерыва.
+    bool read(Snapshot &snapshot,
+              std::chrono::microseconds timeout = default_read_timeout) const;
+    // nullopt - пина нет в таблице или снимок не получен за default_read_timeout
+    std::optional<PinSnapshot> readPin(int pin_number) const;
+
+    // Номер версии таблицы: меняется при каждом изменении пинов
+    uint32_t sequence() const;
+
+private:
+    int fd_ = -1;
+    const shm::Segment *segment_ = nullptr;
+};
+
+} // namespace gpio
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace gpio {
 
 // Тип пина: цифровой или аналоговый
@@ -20,6 +22,21 @@ enum class DigitalValue {
     High
 };
 
+// Фронт, на который срабатывает колбэк цифрового входа
+enum class EdgeMode {
+    Rising,
+    Falling,
+    Both
+};
+
+// Кривая интерполяции плавного изменения аналогового выхода
+enum class Easing {
+    Linear,
+    EaseIn,
+    EaseOut,
+    EaseInOut
+};
+
 struct PinConfig
 {
     int number;
@@ -27,4 +44,13 @@ struct PinConfig
     PinMode mode;
 };
 
+// Состояние пина на момент снимка
+struct PinSnapshot
+{
+    int number;
+    PinType type;
+    PinMode mode;
+    uint8_t value;
+};
+
 } // namespace gpio
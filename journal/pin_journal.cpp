@@ -0,0 +1,311 @@
+#include "pin_journal.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace journal {
+
+namespace {
+
+constexpr uint64_t file_magic = 0x314c4e524a4e4950ULL; // "PINJRNL1"
+constexpr uint32_t file_version = 1;
+
+struct FileHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+};
+
+bool writeAll(int fd, const void *data, std::size_t size)
+{
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+void printError(const std::string &msg)
+{
+    std::cerr << "[PIN_JOURNAL] " << msg << ": " << std::strerror(errno) << std::endl;
+}
+
+} // namespace
+
+struct PinJournal::Record
+{
+    int32_t pin;
+    uint8_t value;
+    uint8_t reserved[3];
+    // FNV-1a от pin и value: отличает оборванную или не дописанную запись
+    uint32_t checksum;
+
+    static uint32_t compute(int32_t pin, uint8_t value)
+    {
+        uint32_t hash = 2166136261u;
+        auto mix = [&hash](uint8_t byte) {
+            hash ^= byte;
+            hash *= 16777619u;
+        };
+        for (int shift = 0; shift < 32; shift += 8) {
+            mix(static_cast<uint8_t>(static_cast<uint32_t>(pin) >> shift));
+        }
+        mix(value);
+        return hash;
+    }
+
+    static Record make(int pin, uint8_t value)
+    {
+        return {static_cast<int32_t>(pin), value, {}, compute(pin, value)};
+    }
+
+    bool valid() const { return checksum == compute(pin, value); }
+};
+
+static_assert(sizeof(FileHeader) == 16);
+
+PinJournal::PinJournal(const std::string &path, std::size_t compact_after)
+    : path_(path)
+    , compact_after_(compact_after)
+    , compact_threshold_(compact_after)
+{
+    static_assert(sizeof(Record) == 12);
+
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open " + path_ + ": " + std::strerror(errno));
+    }
+
+    try {
+        load();
+    } catch (...) {
+        close(fd_);
+        throw;
+    }
+
+    thread_ = std::thread([this] { run(); });
+}
+
+PinJournal::~PinJournal()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void PinJournal::load()
+{
+    struct stat st{};
+    if (fstat(fd_, &st) != 0) {
+        throw std::runtime_error("fstat failed for " + path_ + ": " + std::strerror(errno));
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+
+    FileHeader header{};
+    if (size < sizeof(header) || pread(fd_, &header, sizeof(header), 0) != sizeof(header)
+        || header.magic != file_magic || header.version != file_version
+        || header.record_size != sizeof(Record)) {
+        reset();
+        return;
+    }
+
+    std::vector<Record> records((size - sizeof(header)) / sizeof(Record));
+    const auto length = records.size() * sizeof(Record);
+    if (length > 0
+        && pread(fd_, records.data(), length, sizeof(header)) != static_cast<ssize_t>(length)) {
+        throw std::runtime_error("Failed to read " + path_ + ": " + std::strerror(errno));
+    }
+
+    // Всё после первой повреждённой записи - хвост, не дописанный до сбоя
+    std::size_t valid = 0;
+    while (valid < records.size() && records[valid].valid()) {
+        state_[records[valid].pin] = records[valid].value;
+        ++valid;
+    }
+    file_records_ = valid;
+
+    const auto valid_size = sizeof(header) + valid * sizeof(Record);
+    if (valid_size != size && ftruncate(fd_, static_cast<off_t>(valid_size)) != 0) {
+        throw std::runtime_error("ftruncate failed for " + path_ + ": " + std::strerror(errno));
+    }
+}
+
+void PinJournal::reset()
+{
+    const FileHeader header{file_magic, file_version, sizeof(Record)};
+    if (ftruncate(fd_, 0) != 0 || !writeAll(fd_, &header, sizeof(header)) || fdatasync(fd_) != 0) {
+        throw std::runtime_error("Failed to initialize " + path_ + ": " + std::strerror(errno));
+    }
+    file_records_ = 0;
+}
+
+void PinJournal::record(int pin, uint8_t value)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_[pin] = value;
+        pending_.push_back(Record::make(pin, value));
+        ++recorded_;
+        ++stats_.records;
+    }
+    work_.notify_one();
+}
+
+bool PinJournal::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto target = recorded_;
+    const auto failures = stats_.failed_commits;
+    committed_.wait(lock, [this, target, failures] {
+        return synced_ >= target || stats_.failed_commits != failures;
+    });
+    return synced_ >= target;
+}
+
+PinJournal::State PinJournal::state() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+PinJournal::Stats PinJournal::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PinJournal::run()
+{
+    std::vector<Record> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            break;
+        }
+
+        // Всё, что накопилось, пока шла предыдущая фиксация, уходит одной
+        batch.swap(pending_);
+        const auto last = recorded_;
+        lock.unlock();
+
+        const bool ok = commit(batch);
+
+        lock.lock();
+        if (ok) {
+            synced_ = last;
+            ++stats_.commits;
+        } else {
+            // Пачка возвращается в начало очереди, перед записями, сделанными за время попытки
+            ++stats_.failed_commits;
+            batch.insert(batch.end(), pending_.begin(), pending_.end());
+            pending_.swap(batch);
+        }
+        batch.clear();
+        committed_.notify_all();
+
+        if (!ok) {
+            if (stopping_) {
+                std::cerr << "[PIN_JOURNAL] Dropping " << pending_.size()
+                          << " unsynced record(s) of " << path_ << std::endl;
+                break;
+            }
+            // Остановка прерывает ожидание ради последней попытки
+            work_.wait_for(lock, retry_interval, [this] { return stopping_; });
+            continue;
+        }
+
+        if (file_records_ > compact_threshold_ || compact_due_) {
+            lock.unlock();
+            compact();
+            lock.lock();
+        }
+    }
+}
+
+bool PinJournal::commit(const std::vector<Record> &batch)
+{
+    if (!writeAll(fd_, batch.data(), batch.size() * sizeof(Record)) || fdatasync(fd_) != 0) {
+        printError("Failed to commit " + std::to_string(batch.size()) + " record(s) to " + path_);
+        // Повтор допишется за последней целой записью, а не за обрывком этой пачки
+        const auto committed_size = sizeof(FileHeader) + file_records_ * sizeof(Record);
+        if (ftruncate(fd_, static_cast<off_t>(committed_size)) != 0) {
+            printError("ftruncate failed for " + path_);
+            compact_due_ = true;
+        }
+        return false;
+    }
+    file_records_ += batch.size();
+    return true;
+}
+
+void PinJournal::compact()
+{
+    std::vector<Record> records;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        records.reserve(state_.size());
+        for (const auto &[pin, value] : state_) {
+            records.push_back(Record::make(pin, value));
+        }
+    }
+
+    // Записи, сделанные после снятия состояния, допишутся уже в новый файл
+    const auto tmp_path = path_ + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    const FileHeader header{file_magic, file_version, sizeof(Record)};
+    if (fd < 0 || !writeAll(fd, &header, sizeof(header))
+        || !writeAll(fd, records.data(), records.size() * sizeof(Record)) || fdatasync(fd) != 0
+        || rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        printError("Failed to compact " + path_);
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_path.c_str());
+        }
+        // Следующая попытка - через compact_after записей
+        compact_threshold_ = file_records_ + compact_after_;
+        return;
+    }
+
+    // rename устойчив только после синхронизации каталога
+    auto dir = std::filesystem::path(path_).parent_path();
+    int dir_fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+
+    close(fd_);
+    fd_ = fd;
+    file_records_ = records.size();
+    compact_threshold_ = compact_after_;
+    compact_due_ = false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.compactions;
+}
+
+} // namespace journal
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace journal {
+
+// Журнал записей выходных пинов для восстановления после сбоя и перезапуска.
+// Файл - заголовок и записи фиксированного размера с контрольной суммой, только дописывается.
+// record() не ждёт диска: записи копятся в памяти, а поток журнала сбрасывает всё
+// накопленное за время предыдущего fdatasync одним write и одним fdatasync (групповая
+// фиксация), так что частые записи пинов не упираются в задержку синхронизации.
+// Когда записей в файле становится больше compact_after, файл переписывается последними
+// значениями пинов (через временный файл и rename). Неудачная фиксация отрезается от файла,
+// а её записи остаются в очереди и повторяются через retry_interval. Потокобезопасно.
+class PinJournal
+{
+public:
+    // pin -> последнее записанное значение
+    using State = std::map<int, uint8_t>;
+
+    static constexpr std::size_t default_compact_after = 4096;
+    static constexpr std::chrono::milliseconds retry_interval{100};
+
+    struct Stats
+    {
+        uint64_t records;
+        uint64_t commits;
+        uint64_t compactions;
+        uint64_t failed_commits;
+    };
+
+    // Открывает существующий журнал и читает состояние или создаёт новый. Файл другого
+    // формата переинициализируется, оборванная последняя запись отбрасывается.
+    // Бросает исключение при ошибке ввода-вывода.
+    explicit PinJournal(const std::string &path,
+                        std::size_t compact_after = default_compact_after);
+    // Дописывает и синхронизирует накопленные записи; если не вышло и с последней попытки,
+    // они теряются
+    ~PinJournal();
+
+    PinJournal(const PinJournal &) = delete;
+    PinJournal &operator=(const PinJournal &) = delete;
+
+    // Попадёт на диск со следующей групповой фиксацией
+    void record(int pin, uint8_t value);
+    // Ждёт, пока записи, сделанные до вызова, будут синхронизированы. false - очередная
+    // фиксация не удалась; записи не потеряны и будут повторены
+    [[nodiscard]] bool flush();
+
+    // Последние значения с учётом ещё не синхронизированных записей
+    State state() const;
+    Stats stats() const;
+
+private:
+    struct Record;
+
+    void load();
+    void reset();
+    void run();
+    bool commit(const std::vector<Record> &batch);
+    void compact();
+
+    std::string path_;
+    std::size_t compact_after_;
+    // Пишется только потоком журнала (и конструктором до его запуска)
+    int fd_ = -1;
+    std::size_t file_records_ = 0;
+    // Сжатие - когда записей в файле больше; после неудачного сжатия порог отодвигается
+    std::size_t compact_threshold_;
+    // Неудачную фиксацию не удалось отрезать: файл переписывается после следующей удачной
+    bool compact_due_ = false;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_;
+    std::condition_variable committed_;
+    std::vector<Record> pending_;
+    State state_;
+    // Номера записей: выданный последним и последний синхронизированный (только успешной
+    // фиксацией)
+    uint64_t recorded_ = 0;
+    uint64_t synced_ = 0;
+    Stats stats_{};
+    bool stopping_ = false;
+
+    std::thread thread_;
+};
+
+} // namespace journal
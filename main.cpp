@@ -1,12 +1,18 @@
 #include "application.hpp"
 #include "config.hpp"
 #include "gpio/gpio_manager.hpp"
+#include "mqtt/epoll_reactor.hpp"
 #include "mqtt/mqtt_client.hpp"
+#include "sensor_model.hpp"
 #include "temperature_sensor_emulator.hpp"
+#include "trace.hpp"
 
 #include <cstdlib> // std::getenv
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <random>
+#include <stdexcept>
 #include <string>
 
 std::string getEnvVar(const std::string &key, const std::string &default_value = "")
@@ -25,36 +31,113 @@ int getEnvVarInt(const std::string &key, int default_value)
     return default_value;
 }
 
+// Сводка задержек в stdout, полная трасса - в файл для chrome://tracing
+void dumpTrace(const std::string &path)
+{
+    auto threads = trace::collect();
+    for (const auto &s : trace::summarize(threads)) {
+        std::cout << "[MAIN] trace " << s.name << ": n=" << s.count << " p50=" << s.p50_us
+                  << "us p90=" << s.p90_us << "us p99=" << s.p99_us << "us max=" << s.max_us
+                  << "us" << std::endl;
+    }
+
+    std::ofstream out(path);
+    trace::writeChromeTrace(out, threads);
+}
+
 int main()
 {
     try {
+        const auto trace_file = getEnvVar("TRACE_FILE");
+        trace::enable(!trace_file.empty());
+
         // Заполняем AppConfig
         AppConfig app_config{.max_reconnect_attempts = getEnvVarInt("MAX_RECONNECT_ATTEMPTS", 5),
+                             .button_debounce_ms = getEnvVarInt("BUTTON_DEBOUNCE_MS", 50),
+                             .temperature_period_ms = getEnvVarInt("TEMPERATURE_PERIOD_MS", 5000),
+                             .reconnect_interval_ms = getEnvVarInt("RECONNECT_INTERVAL_MS", 2000),
+                             .pin_snapshot_period_ms = getEnvVarInt("PIN_SNAPSHOT_PERIOD_MS",
+                                                                    30000),
                              .pins = PinConfig{.red_pin = getEnvVarInt("RED_PIN", 3),
                                                .green_pin = getEnvVarInt("GREEN_PIN", 5),
                                                .blue_pin = getEnvVarInt("BLUE_PIN", 6),
                                                .temperature_pin = getEnvVarInt("TEMPERATURE_PIN", 0),
                                                .button_pin = getEnvVarInt("BUTTON_PIN", 2),
-                                               .led_pin = getEnvVarInt("LED_PIN", 13)}};
+                                               .led_pin = getEnvVarInt("LED_PIN", 13)},
+                             .config_file = getEnvVar("CONFIG_FILE", ""),
+                             .status_file = getEnvVar("STATUS_FILE", "")};
 
-        std::unique_ptr<mqtt::IClient> mqtt_client
+        auto mqtt_client_impl
             = std::make_unique<mqtt::Client>(getEnvVar("MQTT_HOST", "localhost"),
                                              getEnvVarInt("MQTT_PORT", 1883),
                                              getEnvVar("MQTT_CLIENT_ID", "embedded_device"),
                                              getEnvVar("MQTT_USERNAME", ""),
                                              getEnvVar("MQTT_PASSWORD", ""));
+        // 311 - для брокеров без MQTT 5: без алиасов топиков и ответов на запросы
+        if (auto protocol = getEnvVar("MQTT_PROTOCOL", "5"); protocol == "311") {
+            mqtt_client_impl->setProtocolVersion(mqtt::Client::ProtocolVersion::V311);
+        } else if (protocol != "5") {
+            throw std::runtime_error("Unknown MQTT_PROTOCOL: " + protocol);
+        }
+        // epoll - сокет обслуживает общий реактор, публикации уходят без ожидания опроса
+        if (auto io = getEnvVar("MQTT_IO", "thread"); io == "epoll") {
+            mqtt_client_impl->setReactor(std::make_shared<mqtt::EpollReactor>());
+        } else if (io != "thread") {
+            throw std::runtime_error("Unknown MQTT_IO: " + io);
+        }
+        std::unique_ptr<mqtt::IClient> mqtt_client = std::move(mqtt_client_impl);
+
+        auto gpio_manager_impl = std::make_unique<gpio::Manager>();
+        if (auto shm_name = getEnvVar("GPIO_SHM_NAME"); !shm_name.empty()) {
+            gpio_manager_impl->exportStateToSharedMemory(shm_name);
+        }
+        std::unique_ptr<gpio::IManager> gpio_manager = std::move(gpio_manager_impl);
+
+        auto clock = std::make_shared<SystemClock>();
+
+        // SENSOR_SEED делает последовательность температур воспроизводимой
+        std::random_device entropy;
+        auto sensor_seed = static_cast<uint32_t>(
+            std::stoul(getEnvVar("SENSOR_SEED", std::to_string(entropy()))));
+        std::unique_ptr<TemperatureSensor> temp_sensor;
+        if (auto model = getEnvVar("SENSOR_MODEL", "uniform"); model == "realistic") {
+            temp_sensor
+                = std::make_unique<ModelTemperatureSensor>(SensorModel{}, sensor_seed, clock);
+        } else if (model == "uniform") {
+            temp_sensor = std::make_unique<TemperatureSensorEmulator<200, 300>>(sensor_seed);
+        } else {
+            throw std::runtime_error("Unknown SENSOR_MODEL: " + model);
+        }
+
+        std::unique_ptr<timeseries::Store> history;
+        if (auto history_file = getEnvVar("HISTORY_FILE"); !history_file.empty()) {
+            auto history_size = static_cast<std::size_t>(getEnvVarInt("HISTORY_SIZE_KB", 1024));
+            history = std::make_unique<timeseries::Store>(history_file, history_size * 1024);
+        }
 
-        std::unique_ptr<gpio::IManager> gpio_manager = std::make_unique<gpio::Manager>();
+        // PIN_JOURNAL_FILE включает восстановление выходов после сбоя и перезапуска
+        std::unique_ptr<journal::PinJournal> pin_journal;
+        if (auto journal_file = getEnvVar("PIN_JOURNAL_FILE"); !journal_file.empty()) {
+            pin_journal = std::make_unique<journal::PinJournal>(journal_file);
+        }
 
-        std::unique_ptr<TemperatureSensor> temp_sensor
-            = std::make_unique<TemperatureSensorEmulator<200, 300>>();
+        {
+            Application app(app_config,
+                            std::move(mqtt_client),
+                            std::move(gpio_manager),
+                            std::move(temp_sensor),
+                            std::move(history),
+                            std::move(pin_journal),
+                            clock);
 
-        Application app(app_config,
-                        std::move(mqtt_client),
-                        std::move(gpio_manager),
-                        std::move(temp_sensor));
+            app.run();
+        }
 
-        app.run();
+        // Потоки клиента, реактора и журнала остановлены вместе с приложением:
+        // выгрузка видит все интервалы
+        if (!trace_file.empty()) {
+            dumpTrace(trace_file);
+        }
     } catch (const std::exception &ex) {
         std::cerr << "[MAIN] Unhandled exception: " << ex.what() << std::endl;
         return 1;
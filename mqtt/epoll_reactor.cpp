@@ -0,0 +1,172 @@
+#include "epoll_reactor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace mqtt {
+
+EpollReactor::EpollReactor()
+{
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        throw std::runtime_error("epoll_create1 failed: " + std::string(std::strerror(errno)));
+    }
+
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ < 0) {
+        close(epoll_fd_);
+        throw std::runtime_error("eventfd failed: " + std::string(std::strerror(errno)));
+    }
+
+    // data.ptr == nullptr отличает eventfd от сокетов источников
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    thread_ = std::thread([this] { run(); });
+}
+
+EpollReactor::~EpollReactor()
+{
+    running_ = false;
+    notify();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    close(wake_fd_);
+    close(epoll_fd_);
+}
+
+void EpollReactor::add(Source &source)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto it = std::find_if(entries_.begin(), entries_.end(), [&source](const auto &entry) {
+            return entry->source == &source;
+        });
+        if (it == entries_.end()) {
+            entries_.push_back(std::make_unique<Entry>(Entry{&source}));
+        }
+    }
+    // Сокет регистрируется в epoll после onWake(), в потоке реактора
+    wake(source);
+}
+
+void EpollReactor::remove(Source &source)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    for (auto &entry : entries_) {
+        if (entry->source == &source) {
+            unregister(*entry);
+            entry->source = nullptr;
+        }
+    }
+}
+
+void EpollReactor::notify()
+{
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(wake_fd_, &one, sizeof(one));
+}
+
+void EpollReactor::run()
+{
+    std::array<epoll_event, 64> events;
+    auto next_tick = std::chrono::steady_clock::now() + tick;
+
+    while (running_) {
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+            next_tick - std::chrono::steady_clock::now());
+        int count = epoll_wait(epoll_fd_,
+                               events.data(),
+                               static_cast<int>(events.size()),
+                               static_cast<int>(std::max<int64_t>(wait.count(), 0)));
+        if (count < 0 && errno != EINTR) {
+            std::cerr << "[MQTT_CLIENT] epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        for (int i = 0; i < count; ++i) {
+            auto *entry = static_cast<Entry *>(events[i].data.ptr);
+            if (!entry) {
+                uint64_t value = 0;
+                [[maybe_unused]] auto read_bytes = read(wake_fd_, &value, sizeof(value));
+                continue;
+            }
+            // Ошибки и разрыв обрабатывает чтение: libmosquitto закроет сокет и сообщит
+            if (entry->source && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+                entry->source->onReadable();
+            }
+            if (entry->source && (events[i].events & EPOLLOUT)) {
+                entry->source->onWritable();
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const bool tick_due = now >= next_tick;
+        if (tick_due) {
+            next_tick = now + tick;
+        }
+
+        // Индексы, а не итераторы: источник может добавить другой источник из колбэка
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            auto &entry = *entries_[i];
+            if (entry.source && (takeWoken(*entry.source) || tick_due)) {
+                entry.source->onWake();
+            }
+            if (entry.source) {
+                sync(entry);
+            }
+        }
+
+        std::erase_if(entries_, [](const auto &entry) { return entry->source == nullptr; });
+    }
+}
+
+void EpollReactor::sync(Entry &entry)
+{
+    const int fd = entry.source->fd();
+    const bool want_write = entry.source->wantWrite();
+    if (fd == entry.fd && want_write == entry.want_write) {
+        return;
+    }
+
+    epoll_event event{};
+    event.events = want_write ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.ptr = &entry;
+
+    if (fd != entry.fd) {
+        unregister(entry);
+        if (fd >= 0) {
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+        }
+    } else if (fd >= 0 && epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) != 0
+               && errno == ENOENT) {
+        // Сокет закрыт и открыт заново под тем же номером - закрытие убрало его из epoll
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    }
+    entry.fd = fd;
+    entry.want_write = want_write;
+}
+
+void EpollReactor::unregister(Entry &entry)
+{
+    if (entry.fd >= 0) {
+        // Уже закрытый сокет epoll убрал сам, ошибка здесь ожидаема
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, entry.fd, nullptr);
+        entry.fd = -1;
+    }
+}
+
+} // namespace mqtt
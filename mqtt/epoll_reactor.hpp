@@ -0,0 +1,59 @@
+#pragma once
+
+#include "reactor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mqtt {
+
+// Реактор на epoll со своим потоком. Публикации будят его через eventfd сразу,
+// без ожидания таймаута опроса.
+class EpollReactor : public Reactor
+{
+public:
+    // Период onWake() без событий: keepalive, повторы QoS 1
+    static constexpr auto tick = std::chrono::milliseconds(1000);
+
+    EpollReactor();
+    ~EpollReactor() override;
+
+    EpollReactor(const EpollReactor &) = delete;
+    EpollReactor &operator=(const EpollReactor &) = delete;
+
+    void add(Source &source) override;
+    void remove(Source &source) override;
+
+protected:
+    void notify() override;
+
+private:
+    struct Entry
+    {
+        // nullptr - удалён, запись убирается после текущего прохода
+        Source *source;
+        int fd = -1;
+        bool want_write = false;
+    };
+
+    void run();
+    void sync(Entry &entry);
+    void unregister(Entry &entry);
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+
+    // Колбэки источников вызываются под этим мьютексом, поэтому remove() из другого потока
+    // дожидается конца прохода. Рекурсивный: источник может удалить себя из колбэка.
+    std::recursive_mutex mutex_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+
+    std::atomic<bool> running_{true};
+    std::thread thread_;
+};
+
+} // namespace mqtt
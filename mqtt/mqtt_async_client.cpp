@@ -0,0 +1,142 @@
+#include "mqtt_async_client.hpp"
+#include <stdexcept>
+
+namespace mqtt {
+
+AsyncClient::AsyncClient(IClient &client, async::Scheduler &scheduler)
+    : client_(client)
+    , scheduler_(scheduler)
+{
+    client_.setConnectCallback([this]() { onConnect(); });
+    client_.setDisconnectCallback([this](int reason) { onDisconnect(reason); });
+}
+
+AsyncClient::~AsyncClient()
+{
+    if (connecting_.valid()) {
+        connecting_.wait();
+    }
+    client_.setConnectCallback(nullptr);
+    client_.setDisconnectCallback(nullptr);
+}
+
+bool AsyncClient::ConnectAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    handle_ = handle;
+    {
+        std::lock_guard<std::mutex> lock(owner_.mutex_);
+        if (owner_.pending_connect_) {
+            error_ = std::make_exception_ptr(std::logic_error("Connect already in progress"));
+            return false;
+        }
+        owner_.pending_connect_ = this;
+    }
+
+    // Разрешение имени и TCP-соединение блокируют до таймаута сети. Колбэк CONNACK
+    // может прийти раньше, чем connect() вернёт управление: корутину возобновляет
+    // первое из событий, остальные видят пустой pending_connect_
+    auto &owner = owner_;
+    if (owner.connecting_.valid()) {
+        owner.connecting_.wait();
+    }
+    owner.connecting_ = std::async(std::launch::async, [&owner] {
+        try {
+            owner.client_.connect();
+        } catch (...) {
+            owner.resumeConnect(std::current_exception());
+        }
+    });
+    return true;
+}
+
+void AsyncClient::ConnectAwaiter::await_resume()
+{
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void AsyncClient::PublishAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    owner_.client_.publish(topic_, payload_, [this, handle](bool delivered) {
+        delivered_ = delivered;
+        owner_.scheduler_.post(handle);
+    });
+}
+
+void AsyncClient::PublishAwaiter::await_resume()
+{
+    if (!delivered_) {
+        throw std::runtime_error("Publish was not acknowledged: " + topic_);
+    }
+}
+
+bool AsyncClient::MessageAwaiter::await_ready()
+{
+    std::lock_guard<std::mutex> lock(owner_.mutex_);
+    return !owner_.messages_.empty();
+}
+
+bool AsyncClient::MessageAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    std::lock_guard<std::mutex> lock(owner_.mutex_);
+    if (!owner_.messages_.empty()) {
+        return false;
+    }
+    owner_.message_waiter_ = handle;
+    return true;
+}
+
+Message AsyncClient::MessageAwaiter::await_resume()
+{
+    std::lock_guard<std::mutex> lock(owner_.mutex_);
+    Message message = std::move(owner_.messages_.front());
+    owner_.messages_.pop_front();
+    return message;
+}
+
+void AsyncClient::subscribe(const std::string &topic_filter)
+{
+    client_.subscribe(topic_filter, [this](const std::string &topic, const std::string &payload) {
+        onMessage(topic, payload);
+    });
+}
+
+void AsyncClient::resumeConnect(std::exception_ptr error)
+{
+    ConnectAwaiter *awaiter = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        awaiter = std::exchange(pending_connect_, nullptr);
+    }
+    if (awaiter) {
+        awaiter->error_ = std::move(error);
+        scheduler_.post(awaiter->handle_);
+    }
+}
+
+void AsyncClient::onConnect()
+{
+    resumeConnect(nullptr);
+}
+
+void AsyncClient::onDisconnect(int reason)
+{
+    resumeConnect(std::make_exception_ptr(
+        std::runtime_error("Disconnected before CONNACK, reason = " + std::to_string(reason))));
+}
+
+void AsyncClient::onMessage(const std::string &topic, const std::string &payload)
+{
+    std::coroutine_handle<> waiter;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        messages_.push_back({topic, payload});
+        waiter = std::exchange(message_waiter_, nullptr);
+    }
+    if (waiter) {
+        scheduler_.post(waiter);
+    }
+}
+
+} // namespace mqtt
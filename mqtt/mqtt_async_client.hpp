@@ -0,0 +1,135 @@
+#pragma once
+
+#include "mqtt_iclient.hpp"
+#include "scheduler.hpp"
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+
+namespace mqtt {
+
+struct Message
+{
+    std::string topic;
+    std::string payload;
+};
+
+// Корутинная обёртка над IClient.
+// Все продолжения возобновляются в потоке планировщика: колбэки из потока mosquitto
+// только ставят корутину в очередь Scheduler::post(), поэтому пользовательский код
+// внутри задач работает однопоточно и не требует мьютексов.
+//
+//     co_await client.connect();
+//     co_await client.publish("embedded/pins/state", payload); // завершится после PUBACK
+//     client.subscribe("embedded/control");
+//     auto msg = co_await client.nextMessage();
+//
+// Забирает себе connect/disconnect колбэки переданного IClient. Ожидающие publish()
+// должны завершиться до разрушения AsyncClient.
+class AsyncClient
+{
+public:
+    class ConnectAwaiter
+    {
+    public:
+        explicit ConnectAwaiter(AsyncClient &owner)
+            : owner_(owner)
+        {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        void await_resume();
+
+    private:
+        friend class AsyncClient;
+
+        AsyncClient &owner_;
+        std::coroutine_handle<> handle_;
+        std::exception_ptr error_;
+    };
+
+    class PublishAwaiter
+    {
+    public:
+        PublishAwaiter(AsyncClient &owner, std::string topic, std::string payload)
+            : owner_(owner)
+            , topic_(std::move(topic))
+            , payload_(std::move(payload))
+        {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume();
+
+    private:
+        AsyncClient &owner_;
+        std::string topic_;
+        std::string payload_;
+        bool delivered_ = false;
+    };
+
+    class MessageAwaiter
+    {
+    public:
+        explicit MessageAwaiter(AsyncClient &owner)
+            : owner_(owner)
+        {}
+
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> handle);
+        Message await_resume();
+
+    private:
+        AsyncClient &owner_;
+    };
+
+    AsyncClient(IClient &client, async::Scheduler &scheduler);
+    // Дожидается фонового подключения
+    ~AsyncClient();
+
+    AsyncClient(const AsyncClient &) = delete;
+    AsyncClient &operator=(const AsyncClient &) = delete;
+
+    // Завершается по CONNACK, при ошибке или потере соединения бросает исключение.
+    // Блокирующий IClient::connect() выполняется в фоновом потоке, как в Application,
+    // планировщик тем временем возобновляет остальные задачи
+    ConnectAwaiter connect() { return ConnectAwaiter(*this); }
+
+    // Завершается по PUBACK (QoS 1), при неудаче бросает исключение
+    PublishAwaiter publish(std::string topic, std::string payload)
+    {
+        return PublishAwaiter(*this, std::move(topic), std::move(payload));
+    }
+
+    // Асинхронный поток входящих сообщений по подпискам subscribe(), по одному
+    // на каждый co_await. Ожидать может одна корутина
+    MessageAwaiter nextMessage() { return MessageAwaiter(*this); }
+
+    // topic_filter может содержать маски '+' и '#'
+    void subscribe(const std::string &topic_filter);
+    void unsubscribe(const std::string &topic_filter) { client_.unsubscribe(topic_filter); }
+    void disconnect() { client_.disconnect(); }
+
+private:
+    void onConnect();
+    void onDisconnect(int reason);
+    void onMessage(const std::string &topic, const std::string &payload);
+    // Завершить ожидающий connect(): error - пустой при успехе
+    void resumeConnect(std::exception_ptr error);
+
+    IClient &client_;
+    async::Scheduler &scheduler_;
+
+    std::mutex mutex_;
+    ConnectAwaiter *pending_connect_ = nullptr;
+    std::deque<Message> messages_;
+    std::coroutine_handle<> message_waiter_;
+    // Фоновый вызов IClient::connect(), последний запущенный
+    std::future<void> connecting_;
+};
+
+} // namespace mqtt
@@ -1,4 +1,6 @@
 #include "mqtt_client.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 namespace mqtt {
@@ -13,6 +15,7 @@ Client::Client(const std::string &host,
     , password_(client_password)
     , host_(host)
     , port_(port)
+    , publish_queue_(default_lane_policies)
 {
     mosquitto_lib_init();
 
@@ -29,9 +32,10 @@ Client::Client(const std::string &host,
         }
     }
 
-    mosquitto_connect_callback_set(mosq_, &Client::onConnectWrapper);
-    mosquitto_disconnect_callback_set(mosq_, &Client::onDisconnectWrapper);
-    mosquitto_message_callback_set(mosq_, &Client::onMessageWrapper);
+    mosquitto_connect_v5_callback_set(mosq_, &Client::onConnectWrapper);
+    mosquitto_disconnect_v5_callback_set(mosq_, &Client::onDisconnectWrapper);
+    mosquitto_message_v5_callback_set(mosq_, &Client::onMessageWrapper);
+    mosquitto_publish_v5_callback_set(mosq_, &Client::onPublishWrapper);
 }
 
 Client::~Client()
@@ -43,49 +47,199 @@ Client::~Client()
     mosquitto_lib_cleanup();
 }
 
+void Client::setProtocolVersion(ProtocolVersion version)
+{
+    protocol_ = version;
+}
+
+uint64_t Client::droppedPublishes(Priority priority) const
+{
+    return publish_queue_.dropped(priority);
+}
+
+void Client::setReactor(std::shared_ptr<Reactor> reactor)
+{
+    reactor_ = std::move(reactor);
+}
+
 void Client::connect()
 {
     static constexpr int keepalive = 60;
     static constexpr int mqtt_timeout_ms = 100;
 
-    int rc = mosquitto_connect(mosq_, host_.c_str(), port_, keepalive);
+    // Цикл ввода-вывода разорванной сессии ещё не остановлен
+    if (attached_ || loop_thread_.joinable()) {
+        disconnect();
+    }
+
+    int rc = mosquitto_int_option(mosq_,
+                                  MOSQ_OPT_PROTOCOL_VERSION,
+                                  protocol_ == ProtocolVersion::V5 ? MQTT_PROTOCOL_V5
+                                                                   : MQTT_PROTOCOL_V311);
+    if (rc != MOSQ_ERR_SUCCESS) {
+        throw std::runtime_error("Failed to set MQTT protocol version: "
+                                 + std::string(mosquitto_strerror(rc)));
+    }
+
+    rc = mosquitto_connect_bind_v5(mosq_, host_.c_str(), port_, keepalive, nullptr, nullptr);
     if (rc != MOSQ_ERR_SUCCESS) {
         throw std::runtime_error("Failed to connect to MQTT broker: "
                                  + std::string(mosquitto_strerror(rc)));
     }
 
     running_ = true;
-    loop_thread_ = std::thread([this] { loop(mqtt_timeout_ms); });
+    if (reactor_) {
+        attached_ = true;
+        reactor_->add(*this);
+    } else {
+        loop_thread_ = std::thread([this] { loop(mqtt_timeout_ms); });
+    }
 }
 
 void Client::disconnect()
 {
-    mosquitto_disconnect(mosq_);
+    mosquitto_disconnect_v5(mosq_, 0, nullptr);
 
+    connected_ = false;
     running_ = false;
+    if (attached_) {
+        reactor_->remove(*this);
+        attached_ = false;
+    }
     if (loop_thread_.joinable()) {
         loop_thread_.join();
     }
+    failPendingDeliveries();
 }
 
 bool Client::isConnected()
 {
-    return loop_thread_.joinable();
+    return connected_;
 }
 
 void Client::subscribe(const std::string &topic)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(router_mutex_);
+        auto filters = router_.filters();
+        if (std::find(filters.begin(), filters.end(), topic) == filters.end()) {
+            router_.add(topic,
+                        [this](const std::string &t,
+                               const std::string &p,
+                               const MessageProperties &) {
+                            if (message_callback_) {
+                                message_callback_(t, p);
+                            }
+                        });
+        }
+    }
+    sendSubscribe(topic);
+}
+
+void Client::subscribe(const std::string &topic_filter, MessageCallback handler)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(router_mutex_);
+        router_.add(topic_filter,
+                    [handler = std::move(handler)](const std::string &t,
+                                                   const std::string &p,
+                                                   const MessageProperties &) { handler(t, p); });
+    }
+    sendSubscribe(topic_filter);
+}
+
+void Client::subscribeRequests(const std::string &topic_filter, RequestCallback handler)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(router_mutex_);
+        router_.add(topic_filter, std::move(handler));
+    }
+    sendSubscribe(topic_filter);
+}
+
+void Client::unsubscribe(const std::string &topic_filter)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(router_mutex_);
+        router_.remove(topic_filter);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int rc = mosquitto_unsubscribe_v5(mosq_, nullptr, topic_filter.c_str(), nullptr);
+    if (rc != MOSQ_ERR_SUCCESS && rc != MOSQ_ERR_NO_CONN) {
+        throw std::runtime_error("Failed to unsubscribe: " + std::string(mosquitto_strerror(rc)));
+    }
+}
+
+void Client::sendSubscribe(const std::string &topic_filter)
 {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    int rc = mosquitto_subscribe(mosq_, nullptr, topic.c_str(), 0);
-    if (rc != MOSQ_ERR_SUCCESS) {
+    // Без соединения подписка будет отправлена из onConnect()
+    int rc = mosquitto_subscribe_v5(mosq_, nullptr, topic_filter.c_str(), 0, 0, nullptr);
+    if (rc != MOSQ_ERR_SUCCESS && rc != MOSQ_ERR_NO_CONN) {
         throw std::runtime_error("Failed to subscribe: " + std::string(mosquitto_strerror(rc)));
     }
 }
 
+void Client::resubscribeAll()
+{
+    std::vector<std::string> filters;
+    {
+        std::shared_lock<std::shared_mutex> lock(router_mutex_);
+        filters = router_.filters();
+    }
+
+    for (const auto &filter : filters) {
+        try {
+            sendSubscribe(filter);
+        } catch (const std::exception &e) {
+            printError("[MQTT_CLIENT] Resubscribe to '" + filter + "' failed: " + e.what());
+        }
+    }
+}
+
 void Client::publish(const std::string &topic, const std::string &payload)
 {
-    publish_queue_.emplace(topic, payload);
+    enqueuePublish(topic, payload, nullptr, {});
+}
+
+void Client::publish(const std::string &topic,
+                     const std::string &payload,
+                     DeliveryCallback on_delivered)
+{
+    enqueuePublish(topic, payload, std::move(on_delivered), {});
+}
+
+void Client::publish(const std::string &topic,
+                     const std::string &payload,
+                     const PublishOptions &options)
+{
+    enqueuePublish(topic, payload, nullptr, options);
+}
+
+void Client::enqueuePublish(const std::string &topic,
+                            const std::string &payload,
+                            DeliveryCallback on_delivered,
+                            const PublishOptions &options)
+{
+    // Слот заполняется на месте: его строки сохраняют буферы прошлых сообщений
+    publish_queue_.push(options.priority,
+                        topic,
+                        options.latest_only,
+                        std::move(on_delivered),
+                        [&](OutgoingMessage &slot) {
+                            slot.topic.assign(topic);
+                            slot.payload.assign(payload);
+                            slot.options.correlation_data.assign(options.correlation_data);
+                            slot.options.user_properties = options.user_properties;
+                            slot.options.retain = options.retain;
+                            slot.trace_id = trace::currentId();
+                            slot.enqueued_ns = slot.trace_id ? trace::nowNs() : 0;
+                        });
+    if (attached_) {
+        reactor_->wake(*this);
+    }
 }
 
 void Client::setMessageCallback(MessageCallback callback)
@@ -115,48 +269,211 @@ void Client::loop(int timeout_ms)
             break;
         }
 
-        if (auto item = publish_queue_.pop(0)) {
-            const auto &[topic, payload] = *item;
-            int rc_pub = mosquitto_publish(mosq_,
-                                           nullptr,
-                                           topic.c_str(),
-                                           payload.size(),
-                                           payload.c_str(),
-                                           0,
-                                           false);
-            if (rc_pub != MOSQ_ERR_SUCCESS) {
-                printError("[MQTT_CLIENT] Publish failed: "
-                           + std::string(mosquitto_strerror(rc_pub)));
+        sendQueued();
+    }
+}
+
+void Client::sendQueued()
+{
+    publish_queue_.takeDropped(dropped_deliveries_);
+    for (auto &on_delivered : dropped_deliveries_) {
+        on_delivered(false);
+    }
+    dropped_deliveries_.clear();
+
+    // Пока сокет не принимает данные, сообщения ждут в полосах, а не в очереди libmosquitto:
+    // иначе срочное сообщение встало бы за всем, что накопилось до него
+    while (!mosquitto_want_write(mosq_) && publish_queue_.tryPopInto(sending_)) {
+        auto *item = &sending_;
+        trace::Context trace_context(item->trace_id);
+        if (item->trace_id) {
+            trace::record("mqtt.publish_queue", item->trace_id, item->enqueued_ns, trace::nowNs());
+        }
+        trace::Scope span("mqtt.publish");
+        // Подтверждаемые сообщения отправляются с QoS 1: on_publish придёт только
+        // после PUBACK из этого же потока, поэтому mid успевает попасть в pending_deliveries_
+        const int qos = item->on_delivered ? 1 : 0;
+        int mid = 0;
+        int rc_pub = sendPublish(item->topic, item->payload, qos, item->options, &mid);
+        if (rc_pub != MOSQ_ERR_SUCCESS) {
+            printError("[MQTT_CLIENT] Publish failed: "
+                       + std::string(mosquitto_strerror(rc_pub)));
+            if (item->on_delivered) {
+                item->on_delivered(false);
+            }
+        } else if (item->on_delivered) {
+            pending_deliveries_.emplace(mid, std::move(item->on_delivered));
+        }
+    }
+}
+
+int Client::fd() const
+{
+    return mosquitto_socket(mosq_);
+}
+
+bool Client::wantWrite() const
+{
+    return mosquitto_want_write(mosq_);
+}
+
+void Client::onReadable()
+{
+    handleLoopResult(mosquitto_loop_read(mosq_, 1));
+}
+
+void Client::onWritable()
+{
+    handleLoopResult(mosquitto_loop_write(mosq_, 1));
+    // Сокет освободился - очередь продолжает отправку
+    if (running_ && !mosquitto_want_write(mosq_)) {
+        sendQueued();
+    }
+}
+
+void Client::onWake()
+{
+    // Без соединения публикации копятся в очереди, как и с собственным потоком
+    if (!running_) {
+        return;
+    }
+    handleLoopResult(mosquitto_loop_misc(mosq_));
+    sendQueued();
+}
+
+void Client::handleLoopResult(int rc)
+{
+    // Разрыв соединения libmosquitto обрабатывает сама и вызывает on_disconnect
+    if (rc != MOSQ_ERR_SUCCESS && rc != MOSQ_ERR_NO_CONN && running_) {
+        printError("[MQTT_CLIENT] loop error: " + std::string(mosquitto_strerror(rc)));
+    }
+}
+
+int Client::sendPublish(const std::string &topic,
+                        const std::string &payload,
+                        int qos,
+                        const PublishOptions &options,
+                        int *mid)
+{
+    if (protocol_ != ProtocolVersion::V5) {
+        return mosquitto_publish(mosq_,
+                                 mid,
+                                 topic.c_str(),
+                                 payload.size(),
+                                 payload.c_str(),
+                                 qos,
+                                 options.retain);
+    }
+
+    mosquitto_property *properties = nullptr;
+    if (!options.correlation_data.empty()) {
+        mosquitto_property_add_binary(&properties,
+                                      MQTT_PROP_CORRELATION_DATA,
+                                      options.correlation_data.data(),
+                                      options.correlation_data.size());
+    }
+    for (const auto &[name, value] : options.user_properties) {
+        mosquitto_property_add_string_pair(&properties,
+                                           MQTT_PROP_USER_PROPERTY,
+                                           name.c_str(),
+                                           value.c_str());
+    }
+
+    // Алиасы только для QoS 0: при повторной отправке QoS 1 после переподключения
+    // соответствие алиаса топику у брокера уже потеряно
+    TopicAlias *alias = nullptr;
+    if (qos == 0 && topic_alias_maximum_ > 0) {
+        auto it = topic_aliases_.find(topic);
+        if (it == topic_aliases_.end() && topic_aliases_.size() < max_alias_candidates) {
+            it = topic_aliases_.emplace(topic, TopicAlias{}).first;
+        }
+        if (it != topic_aliases_.end()) {
+            alias = &it->second;
+            if (alias->alias == 0 && ++alias->publishes >= alias_after_publishes
+                && next_alias_ <= topic_alias_maximum_) {
+                alias->alias = next_alias_++;
+            }
+            if (alias->alias != 0) {
+                mosquitto_property_add_int16(&properties, MQTT_PROP_TOPIC_ALIAS, alias->alias);
             }
         }
     }
+
+    // После установления алиаса топик не передаётся - экономия его длины в каждом пакете
+    const bool omit_topic = alias && alias->established;
+    int rc = mosquitto_publish_v5(mosq_,
+                                  mid,
+                                  omit_topic ? nullptr : topic.c_str(),
+                                  payload.size(),
+                                  payload.c_str(),
+                                  qos,
+                                  options.retain,
+                                  properties);
+    mosquitto_property_free_all(&properties);
+
+    if (rc == MOSQ_ERR_SUCCESS && alias && alias->alias != 0) {
+        alias->established = true;
+    }
+    return rc;
 }
 
-void Client::onConnectWrapper(struct mosquitto *mosq, void *obj, int rc)
+void Client::onConnectWrapper(struct mosquitto *mosq,
+                              void *obj,
+                              int rc,
+                              int,
+                              const mosquitto_property *properties)
 {
     if (auto *self = static_cast<Client *>(obj)) {
-        self->onConnect(rc);
+        self->onConnect(rc, properties);
     }
 }
 
-void Client::onDisconnectWrapper(struct mosquitto *mosq, void *obj, int rc)
+void Client::onDisconnectWrapper(struct mosquitto *mosq,
+                                 void *obj,
+                                 int rc,
+                                 const mosquitto_property *)
 {
     if (auto *self = static_cast<Client *>(obj)) {
         self->onDisconnect(rc);
     }
 }
 
-void Client::onMessageWrapper(struct mosquitto *mosq, void *obj, const struct mosquitto_message *msg)
+void Client::onMessageWrapper(struct mosquitto *mosq,
+                              void *obj,
+                              const struct mosquitto_message *msg,
+                              const mosquitto_property *properties)
+{
+    if (auto *self = static_cast<Client *>(obj)) {
+        self->onMessage(msg, properties);
+    }
+}
+
+void Client::onPublishWrapper(struct mosquitto *mosq,
+                              void *obj,
+                              int mid,
+                              int,
+                              const mosquitto_property *)
 {
     if (auto *self = static_cast<Client *>(obj)) {
-        self->onMessage(msg);
+        self->onPublish(mid);
     }
 }
 
-void Client::onConnect(int rc)
+void Client::onConnect(int rc, const mosquitto_property *properties)
 {
     if (rc == 0) {
+        // Без свойства в CONNACK брокер алиасы не принимает
+        topic_alias_maximum_ = 0;
+        mosquitto_property_read_int16(properties,
+                                      MQTT_PROP_TOPIC_ALIAS_MAXIMUM,
+                                      &topic_alias_maximum_,
+                                      false);
+        topic_aliases_.clear();
+        next_alias_ = 1;
+
         printMessage("[MQTT_CLIENT] Connected successfully");
+        connected_ = true;
+        resubscribeAll();
         if (connect_callback_) {
             connect_callback_();
         }
@@ -168,22 +485,105 @@ void Client::onConnect(int rc)
 void Client::onDisconnect(int rc)
 {
     printMessage("[MQTT_CLIENT] Disconnected: " + std::to_string(rc));
+    connected_ = false;
     running_ = false;
+    failPendingDeliveries();
 
     if (disconnect_callback_) {
         disconnect_callback_(rc);
     }
 }
 
-void Client::onMessage(const struct mosquitto_message *msg)
+void Client::onMessage(const struct mosquitto_message *msg, const mosquitto_property *properties)
 {
-    if (message_callback_ && msg && msg->payload) {
-        std::string topic = msg->topic ? msg->topic : "";
-        std::string payload(static_cast<char *>(msg->payload), msg->payloadlen);
+    if (!msg || !msg->payload) {
+        return;
+    }
+
+    // Трасса команды начинается здесь, обработчики подписок видят её как текущую
+    trace::Context trace_context(trace::newId());
+    trace::Scope span("mqtt.receive");
+
+    // Буферы входящего сообщения переиспользуются, после первых сообщений приём не выделяет
+    // память в куче. Исключение - пользовательские свойства: их пары создаются заново
+    auto &topic = incoming_topic_;
+    auto &payload = incoming_payload_;
+    auto &message_properties = incoming_properties_;
+    topic.assign(msg->topic ? msg->topic : "");
+    payload.assign(static_cast<const char *>(msg->payload), msg->payloadlen);
+    message_properties.response_topic.clear();
+    message_properties.correlation_data.clear();
+    message_properties.user_properties.clear();
+
+    // Строки и данные свойств выделяются libmosquitto (malloc) и освобождаются вызывающим
+    char *response_topic = nullptr;
+    if (mosquitto_property_read_string(properties,
+                                       MQTT_PROP_RESPONSE_TOPIC,
+                                       &response_topic,
+                                       false)) {
+        message_properties.response_topic.assign(response_topic);
+        free(response_topic);
+    }
+    void *correlation = nullptr;
+    uint16_t correlation_length = 0;
+    if (mosquitto_property_read_binary(properties,
+                                       MQTT_PROP_CORRELATION_DATA,
+                                       &correlation,
+                                       &correlation_length,
+                                       false)) {
+        message_properties.correlation_data.assign(static_cast<char *>(correlation),
+                                                   correlation_length);
+        free(correlation);
+    }
+    char *name = nullptr;
+    char *value = nullptr;
+    for (auto *property = mosquitto_property_read_string_pair(properties,
+                                                              MQTT_PROP_USER_PROPERTY,
+                                                              &name,
+                                                              &value,
+                                                              false);
+         property;
+         property = mosquitto_property_read_string_pair(property,
+                                                        MQTT_PROP_USER_PROPERTY,
+                                                        &name,
+                                                        &value,
+                                                        true)) {
+        message_properties.user_properties.emplace_back(name, value);
+        free(name);
+        free(value);
+    }
+
+    std::size_t routed = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(router_mutex_);
+        routed = router_.route(topic, payload, message_properties);
+    }
+
+    if (!routed && message_callback_) {
         message_callback_(topic, payload);
     }
 }
 
+void Client::onPublish(int mid)
+{
+    auto it = pending_deliveries_.find(mid);
+    if (it == pending_deliveries_.end()) {
+        return;
+    }
+    auto on_delivered = std::move(it->second);
+    pending_deliveries_.erase(it);
+    on_delivered(true);
+}
+
+void Client::failPendingDeliveries()
+{
+    auto pending = std::move(pending_deliveries_);
+    pending_deliveries_.clear();
+    for (auto &[mid, on_delivered] : pending) {
+        on_delivered(false);
+    }
+}
+
 void Client::printMessage(const std::string &msg)
 {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -1,20 +1,37 @@
 #pragma once
 
 #include "mqtt_iclient.hpp"
-#include "safe_queue.hpp"
+#include "publish_lanes.hpp"
+#include "reactor.hpp"
+#include "topic_router.hpp"
+#include "trace.hpp"
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <mosquitto.h>
+#include <shared_mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace mqtt {
 
-class Client : public IClient
+class Client : public IClient, private Reactor::Source
 {
 public:
     using MessageCallback = std::function<void(const std::string &, const std::string &)>;
     using ConnectCallback = std::function<void()>;
     using DisconnectCallback = std::function<void(int reason_code)>;
+    using DeliveryCallback = std::function<void(bool delivered)>;
+
+    enum class ProtocolVersion { V311, V5 };
+
+    // Сколько раз топик публикуется с QoS 0, прежде чем ему назначается topic alias
+    static constexpr uint32_t alias_after_publishes = 2;
+    // Сколько разных топиков отслеживается для назначения алиасов
+    static constexpr std::size_t max_alias_candidates = 256;
 
     Client(const std::string &host,
            int port,
@@ -29,44 +46,146 @@ public:
     Client(Client &&) noexcept = delete;
     Client &operator=(Client &&) noexcept = delete;
 
+    // Версия протокола для следующего connect(), по умолчанию MQTT 5
+    void setProtocolVersion(ProtocolVersion version);
+    // Сообщения полосы очереди отправки, которые не будут отправлены
+    uint64_t droppedPublishes(Priority priority) const;
+    // Обслуживание сокета внешним реактором вместо собственного потока, до connect().
+    // Реактор может быть общим для нескольких клиентов.
+    void setReactor(std::shared_ptr<Reactor> reactor);
+
     void connect() override final;
     void disconnect() override final;
     bool isConnected() override final;
     void subscribe(const std::string &topic) override final;
+    void subscribe(const std::string &topic_filter, MessageCallback handler) override final;
+    void unsubscribe(const std::string &topic_filter) override final;
     void publish(const std::string &topic, const std::string &payload) override final;
+    void publish(const std::string &topic,
+                 const std::string &payload,
+                 DeliveryCallback on_delivered) override final;
+    void subscribeRequests(const std::string &topic_filter, RequestCallback handler) override final;
+    void publish(const std::string &topic,
+                 const std::string &payload,
+                 const PublishOptions &options) override final;
     void setMessageCallback(MessageCallback callback) override final;
     void setConnectCallback(ConnectCallback callback) override final;
     void setDisconnectCallback(DisconnectCallback callback) override final;
 
 private:
-    static void onConnectWrapper(struct mosquitto *, void *, int rc);
-    static void onDisconnectWrapper(struct mosquitto *, void *, int rc);
-    static void onMessageWrapper(struct mosquitto *, void *, const struct mosquitto_message *);
-
-    void onConnect(int rc);
+    // Тесты вызывают колбэки libmosquitto напрямую, без брокера
+    friend struct ClientTestAccess;
+
+    static void onConnectWrapper(struct mosquitto *,
+                                 void *,
+                                 int rc,
+                                 int flags,
+                                 const mosquitto_property *);
+    static void onDisconnectWrapper(struct mosquitto *, void *, int rc, const mosquitto_property *);
+    static void onMessageWrapper(struct mosquitto *,
+                                 void *,
+                                 const struct mosquitto_message *,
+                                 const mosquitto_property *);
+    static void onPublishWrapper(struct mosquitto *,
+                                 void *,
+                                 int mid,
+                                 int reason_code,
+                                 const mosquitto_property *);
+
+    void onConnect(int rc, const mosquitto_property *properties);
     void onDisconnect(int rc);
-    void onMessage(const struct mosquitto_message *msg);
+    void onMessage(const struct mosquitto_message *msg, const mosquitto_property *properties);
+    void onPublish(int mid);
     void loop(int timeout_ms);
+    void sendQueued();
+
+    // Reactor::Source, вызываются из потока реактора
+    int fd() const override;
+    bool wantWrite() const override;
+    void onReadable() override;
+    void onWritable() override;
+    void onWake() override;
+    void handleLoopResult(int rc);
+    void enqueuePublish(const std::string &topic,
+                        const std::string &payload,
+                        DeliveryCallback on_delivered,
+                        const PublishOptions &options);
+    int sendPublish(const std::string &topic,
+                    const std::string &payload,
+                    int qos,
+                    const PublishOptions &options,
+                    int *mid);
+    void failPendingDeliveries();
+    void sendSubscribe(const std::string &topic_filter);
+    void resubscribeAll();
 
     void printMessage(const std::string &msg);
     void printError(const std::string &msg);
 
 private:
+    struct OutgoingMessage
+    {
+        std::string topic;
+        std::string payload;
+        DeliveryCallback on_delivered;
+        PublishOptions options;
+        // Трасса команды, в обработке которой сделана публикация, и время постановки в очередь
+        uint64_t trace_id = 0;
+        int64_t enqueued_ns = 0;
+    };
+
+    // Состояние topic alias исходящего топика, используется только из потока ввода-вывода
+    struct TopicAlias
+    {
+        uint32_t publishes = 0;
+        uint16_t alias = 0;
+        // Брокер уже знает соответствие алиаса топику, топик можно не передавать
+        bool established = false;
+    };
+
     std::string id_;
     std::string username_;
     std::string password_;
     std::string host_;
     int port_;
+    ProtocolVersion protocol_ = ProtocolVersion::V5;
 
     bool running_{false};
     std::thread loop_thread_;
-    SafeQueue<std::pair<std::string, std::string>> publish_queue_;
+    // При заданном реакторе loop_thread_ не запускается
+    std::shared_ptr<Reactor> reactor_;
+    // Читается в publish() из любых потоков
+    std::atomic<bool> attached_{false};
+    // Сессия с брокером установлена: от onConnect до onDisconnect или disconnect().
+    // Цикл ввода-вывода после разрыва ещё работает, поэтому по нему не судят
+    std::atomic<bool> connected_{false};
+    PublishLanes<OutgoingMessage> publish_queue_;
+    // Колбэки подтверждения вытесненных из очереди сообщений; только из потока ввода-вывода
+    std::vector<DeliveryCallback> dropped_deliveries_;
+    // Отправляемое сообщение, обменивается со слотом очереди; только из потока ввода-вывода
+    OutgoingMessage sending_;
+    // mid -> колбэк подтверждения, используется только из потока ввода-вывода
+    // (loop_thread_ или поток реактора)
+    std::unordered_map<int, DeliveryCallback> pending_deliveries_;
+    // Входящее сообщение, переиспользуется между вызовами onMessage(); только из потока
+    // ввода-вывода
+    std::string incoming_topic_;
+    std::string incoming_payload_;
+    MessageProperties incoming_properties_;
+    // Алиасы действуют в пределах соединения, сбрасываются в onConnect()
+    std::unordered_map<std::string, TopicAlias> topic_aliases_;
+    // Topic Alias Maximum из CONNACK брокера, 0 - алиасы запрещены
+    uint16_t topic_alias_maximum_ = 0;
+    uint16_t next_alias_ = 1;
 
     MessageCallback message_callback_ = nullptr;
     ConnectCallback connect_callback_ = nullptr;
     DisconnectCallback disconnect_callback_ = nullptr;
 
     mutable std::mutex mutex_;
+    // Читается в потоке mosquitto на каждое сообщение, меняется только при (от)подписке
+    mutable std::shared_mutex router_mutex_;
+    TopicRouter router_;
 
     struct mosquitto *mosq_ = nullptr;
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "mqtt_properties.hpp"
+
 #include <string>
 #include <functional>
 
@@ -10,13 +12,39 @@ public:
 
     virtual void connect() = 0;
     virtual void disconnect() = 0;
+    // Сессия с брокером установлена; после разрыва - false до следующего подключения
     virtual bool isConnected() = 0;
+    // Подписка без обработчика: сообщения уходят в общий MessageCallback
     virtual void subscribe(const std::string& topic) = 0;
     virtual void publish(const std::string& topic, const std::string& payload) = 0;
 
     using MessageCallback = std::function<void(const std::string&, const std::string&)>;
     using ConnectCallback = std::function<void()>;
     using DisconnectCallback = std::function<void(int)>;
+    using DeliveryCallback = std::function<void(bool delivered)>;
+    using RequestCallback = std::function<void(const std::string& topic,
+                                               const std::string& payload,
+                                               const MessageProperties& properties)>;
+
+    // Публикация с QoS 1: on_delivered вызывается из потока клиента после PUBACK
+    // (или с false, если сообщение не удалось отправить / соединение потеряно)
+    virtual void publish(const std::string& topic,
+                         const std::string& payload,
+                         DeliveryCallback on_delivered) = 0;
+
+    // Подписка с собственным обработчиком, topic_filter может содержать маски '+' и '#'.
+    // Обработчик вызывается из потока клиента и не должен сам вызывать subscribe/unsubscribe;
+    // подписки восстанавливаются после переподключения.
+    virtual void subscribe(const std::string& topic_filter, MessageCallback handler) = 0;
+    virtual void unsubscribe(const std::string& topic_filter) = 0;
+
+    // Как subscribe(), но обработчик получает свойства MQTT 5: response topic,
+    // correlation data и user properties
+    virtual void subscribeRequests(const std::string& topic_filter, RequestCallback handler) = 0;
+    // Публикация с QoS 0 и свойствами MQTT 5, например ответ в response topic запроса
+    virtual void publish(const std::string& topic,
+                         const std::string& payload,
+                         const PublishOptions& options) = 0;
 
     virtual void setMessageCallback(MessageCallback callback) = 0;
     virtual void setConnectCallback(ConnectCallback callback) = 0;
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mqtt {
+
+using UserProperties = std::vector<std::pair<std::string, std::string>>;
+
+// Свойства MQTT 5 входящего сообщения, при MQTT 3.1.1 пустые
+struct MessageProperties
+{
+    // Куда и с какими данными корреляции отправить ответ (request/response)
+    std::string response_topic;
+    std::string correlation_data;
+    UserProperties user_properties;
+};
+
+// Полоса очереди отправки, полосы обслуживаются строго по порядку: сообщение полосы
+// Telemetry уходит, только когда пусты High и Normal
+enum class Priority {
+    // Подтверждения команд, ответы, ошибки
+    High,
+    Normal,
+    // Периодические значения, которые можно терять
+    Telemetry
+};
+
+inline constexpr std::size_t priority_count = 3;
+
+// Параметры исходящего сообщения; свойства MQTT 5 при MQTT 3.1.1 не передаются
+struct PublishOptions
+{
+    std::string correlation_data;
+    UserProperties user_properties;
+    // Брокер хранит последнее такое сообщение топика и отдаёт его новым подписчикам
+    bool retain = false;
+    Priority priority = Priority::Normal;
+    // Ещё не отправленное сообщение того же топика в полосе заменяется этим:
+    // для значений, где важно только последнее (температура, снимок состояния)
+    bool latest_only = false;
+};
+
+} // namespace mqtt
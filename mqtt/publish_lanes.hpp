@@ -0,0 +1,152 @@
+#pragma once
+
+#include "mqtt_properties.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mqtt {
+
+struct LanePolicy
+{
+    std::size_t capacity;
+    // Заполненная полоса вытесняет самое старое сообщение, иначе отвергает новое
+    bool drop_oldest;
+};
+
+// Подтверждения и ошибки не теряются, пока полоса не заполнена; остальные полосы
+// при переполнении вытесняют самые старые сообщения
+inline constexpr std::array<LanePolicy, priority_count> default_lane_policies = {{
+    {256, false}, // High
+    {1024, true}, // Normal
+    {1024, true}, // Telemetry
+}};
+
+// Очередь исходящих сообщений из полос приоритета (Priority): у каждой полосы своё кольцо
+// слотов фиксированного размера и своя политика переполнения. Слоты переиспользуются,
+// как в SafeQueue. Message - структура с полями topic и on_delivered. Потокобезопасно.
+template<typename Message>
+class PublishLanes
+{
+public:
+    using Callback = decltype(Message::on_delivered);
+
+    explicit PublishLanes(const std::array<LanePolicy, priority_count> &policies)
+    {
+        for (std::size_t i = 0; i < priority_count; ++i) {
+            lanes_[i].policy = policies[i];
+            lanes_[i].slots.resize(policies[i].capacity);
+        }
+    }
+
+    PublishLanes(const PublishLanes &) = delete;
+    PublishLanes &operator=(const PublishLanes &) = delete;
+
+    // fill(Message &) заполняет слот на месте, кроме on_delivered. При latest_only слотом
+    // становится ещё не отправленное сообщение того же топика. Колбэки подтверждения
+    // сообщений, которые так и не уйдут (вытесненных, заменённых, отвергнутых), копятся
+    // до takeDropped(). false - сообщение отвергнуто.
+    template<typename Fill>
+    bool push(Priority priority,
+              std::string_view topic,
+              bool latest_only,
+              Callback on_delivered,
+              Fill &&fill)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &lane = lanes_[static_cast<std::size_t>(priority)];
+
+        Message *slot = latest_only ? lane.find(topic) : nullptr;
+        if (!slot && lane.count < lane.slots.size()) {
+            slot = &lane.slots[(lane.head + lane.count) % lane.slots.size()];
+            ++lane.count;
+        } else {
+            if (!slot && !lane.policy.drop_oldest) {
+                ++lane.dropped;
+                dropLater(std::move(on_delivered));
+                return false;
+            }
+            if (!slot) {
+                // Самое старое сообщение уступает место и становится последним
+                slot = &lane.slots[lane.head];
+                lane.head = (lane.head + 1) % lane.slots.size();
+            }
+            ++lane.dropped;
+            dropLater(std::move(slot->on_delivered));
+        }
+
+        fill(*slot);
+        slot->on_delivered = std::move(on_delivered);
+        return true;
+    }
+
+    // Первое сообщение самой приоритетной непустой полосы, обменом с out
+    bool tryPopInto(Message &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &lane : lanes_) {
+            if (lane.count == 0) {
+                continue;
+            }
+            using std::swap;
+            swap(out, lane.slots[lane.head]);
+            lane.head = (lane.head + 1) % lane.slots.size();
+            --lane.count;
+            return true;
+        }
+        return false;
+    }
+
+    // Обменивает накопленные колбэки неотправленных сообщений с out
+    void takeDropped(std::vector<Callback> &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.swap(dropped_callbacks_);
+    }
+
+    // Сообщения полосы, которые не будут отправлены
+    uint64_t dropped(Priority priority) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lanes_[static_cast<std::size_t>(priority)].dropped;
+    }
+
+private:
+    struct Lane
+    {
+        LanePolicy policy{};
+        std::vector<Message> slots;
+        std::size_t head = 0;
+        std::size_t count = 0;
+        uint64_t dropped = 0;
+
+        Message *find(std::string_view topic)
+        {
+            for (std::size_t i = 0; i < count; ++i) {
+                auto &message = slots[(head + i) % slots.size()];
+                if (message.topic == topic) {
+                    return &message;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    void dropLater(Callback &&on_delivered)
+    {
+        if (on_delivered) {
+            dropped_callbacks_.push_back(std::move(on_delivered));
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::array<Lane, priority_count> lanes_;
+    std::vector<Callback> dropped_callbacks_;
+};
+
+} // namespace mqtt
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+
+namespace mqtt {
+
+// Внешний цикл ввода-вывода для клиентов: вместо собственного потока с mosquitto_loop
+// клиент отдаёт свой сокет реактору, и несколько клиентов обслуживаются одним потоком.
+class Reactor
+{
+public:
+    // Участник реактора. Все методы, кроме конструктора и деструктора, вызываются
+    // из потока реактора.
+    class Source
+    {
+    public:
+        virtual ~Source() = default;
+
+        // Текущий сокет, -1 - нет соединения. Может меняться после переподключения.
+        virtual int fd() const = 0;
+        virtual bool wantWrite() const = 0;
+        virtual void onReadable() = 0;
+        virtual void onWritable() = 0;
+        // После wake() и периодически: служебная работа (keepalive, очередь публикаций)
+        virtual void onWake() = 0;
+
+    private:
+        friend class Reactor;
+        std::atomic<bool> woken_{false};
+    };
+
+    virtual ~Reactor() = default;
+
+    virtual void add(Source &source) = 0;
+    // После возврата реактор больше не обращается к source
+    virtual void remove(Source &source) = 0;
+
+    // Потокобезопасно: вызвать source.onWake() в потоке реактора как можно скорее
+    void wake(Source &source)
+    {
+        source.woken_.store(true, std::memory_order_release);
+        notify();
+    }
+
+protected:
+    // Разбудить поток реактора
+    virtual void notify() = 0;
+
+    static bool takeWoken(Source &source)
+    {
+        return source.woken_.exchange(false, std::memory_order_acq_rel);
+    }
+};
+
+} // namespace mqtt
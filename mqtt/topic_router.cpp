@@ -0,0 +1,214 @@
+#include "topic_router.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace mqtt {
+
+namespace {
+
+// Отделяет первый уровень топика: "a/b/c" -> "a", остаток "b/c"
+std::string_view splitLevel(std::string_view &rest, bool &at_end)
+{
+    auto pos = rest.find('/');
+    std::string_view level = rest.substr(0, pos);
+    if (pos == std::string_view::npos) {
+        rest = {};
+        at_end = true;
+    } else {
+        rest.remove_prefix(pos + 1);
+    }
+    return level;
+}
+
+} // namespace
+
+bool TopicRouter::isValidFilter(std::string_view filter)
+{
+    if (filter.empty()) {
+        return false;
+    }
+
+    bool at_end = false;
+    while (!at_end) {
+        std::string_view level = splitLevel(filter, at_end);
+        if (level == "#") {
+            return at_end;
+        }
+        if (level != "+" && level.find_first_of("+#") != std::string_view::npos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TopicRouter::SubscriptionId TopicRouter::add(const std::string &filter, Handler handler)
+{
+    if (!isValidFilter(filter)) {
+        throw std::invalid_argument("Invalid topic filter: " + filter);
+    }
+
+    Subscription subscription{filter, std::move(handler)};
+
+    std::uint32_t node = 0;
+    std::string_view rest = filter;
+    bool at_end = false;
+    while (!at_end) {
+        std::string_view level = splitLevel(rest, at_end);
+        if (level == "#") {
+            subscription.is_multi = true;
+            break;
+        }
+        if (level == "+") {
+            if (nodes_[node].plus_child == no_node) {
+                nodes_.emplace_back();
+                nodes_[node].plus_child = static_cast<std::uint32_t>(nodes_.size() - 1);
+            }
+            node = nodes_[node].plus_child;
+        } else {
+            node = childFor(node, level);
+        }
+    }
+    subscription.node = node;
+
+    SubscriptionId id;
+    if (!free_ids_.empty()) {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+        subscriptions_[id] = std::move(subscription);
+    } else {
+        id = static_cast<SubscriptionId>(subscriptions_.size());
+        subscriptions_.push_back(std::move(subscription));
+    }
+
+    auto &target = subscriptions_[id].is_multi ? nodes_[node].multi : nodes_[node].exact;
+    target.push_back(id);
+    ++active_count_;
+    return id;
+}
+
+bool TopicRouter::remove(SubscriptionId id)
+{
+    if (id >= subscriptions_.size() || subscriptions_[id].node == no_node) {
+        return false;
+    }
+
+    auto &subscription = subscriptions_[id];
+    auto &ids = subscription.is_multi ? nodes_[subscription.node].multi
+                                      : nodes_[subscription.node].exact;
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+
+    // Узлы дерева не освобождаются: набор фильтров на устройстве практически статичен
+    subscription = Subscription{};
+    free_ids_.push_back(id);
+    --active_count_;
+    return true;
+}
+
+std::size_t TopicRouter::remove(const std::string &filter)
+{
+    std::size_t removed = 0;
+    for (SubscriptionId id = 0; id < subscriptions_.size(); ++id) {
+        if (subscriptions_[id].node != no_node && subscriptions_[id].filter == filter) {
+            remove(id);
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+std::size_t TopicRouter::route(const std::string &topic,
+                               const std::string &payload,
+                               const MessageProperties &properties) const
+{
+    if (topic.empty() || active_count_ == 0) {
+        return 0;
+    }
+    return match(0, topic, false, topic, payload, properties);
+}
+
+std::vector<std::string> TopicRouter::filters() const
+{
+    std::vector<std::string> result;
+    for (const auto &subscription : subscriptions_) {
+        if (subscription.node != no_node
+            && std::find(result.begin(), result.end(), subscription.filter) == result.end()) {
+            result.push_back(subscription.filter);
+        }
+    }
+    return result;
+}
+
+std::uint32_t TopicRouter::childFor(std::uint32_t node, std::string_view level)
+{
+    auto &children = nodes_[node].children;
+    auto it = std::lower_bound(children.begin(),
+                               children.end(),
+                               level,
+                               [](const auto &child, std::string_view key) {
+                                   return std::string_view(child.first) < key;
+                               });
+    if (it != children.end() && it->first == level) {
+        return it->second;
+    }
+
+    auto index = static_cast<std::uint32_t>(nodes_.size());
+    children.emplace(it, std::string(level), index);
+    // emplace_back может инвалидировать ссылку children, поэтому узел создаётся последним
+    nodes_.emplace_back();
+    return index;
+}
+
+std::uint32_t TopicRouter::findChild(std::uint32_t node, std::string_view level) const
+{
+    const auto &children = nodes_[node].children;
+    auto it = std::lower_bound(children.begin(),
+                               children.end(),
+                               level,
+                               [](const auto &child, std::string_view key) {
+                                   return std::string_view(child.first) < key;
+                               });
+    if (it != children.end() && it->first == level) {
+        return it->second;
+    }
+    return no_node;
+}
+
+std::size_t TopicRouter::match(std::uint32_t node,
+                               std::string_view rest,
+                               bool at_end,
+                               const std::string &topic,
+                               const std::string &payload,
+                               const MessageProperties &properties) const
+{
+    const Node &current = nodes_[node];
+    // Топики на '$' (служебные топики брокера) не совпадают с масками на первом уровне
+    const bool wildcards_allowed = node != 0 || topic.front() != '$';
+
+    std::size_t matched = wildcards_allowed ? invoke(current.multi, topic, payload, properties)
+                                            : 0;
+    if (at_end) {
+        return matched + invoke(current.exact, topic, payload, properties);
+    }
+
+    std::string_view level = splitLevel(rest, at_end);
+    if (auto child = findChild(node, level); child != no_node) {
+        matched += match(child, rest, at_end, topic, payload, properties);
+    }
+    if (wildcards_allowed && current.plus_child != no_node) {
+        matched += match(current.plus_child, rest, at_end, topic, payload, properties);
+    }
+    return matched;
+}
+
+std::size_t TopicRouter::invoke(const std::vector<SubscriptionId> &ids,
+                                const std::string &topic,
+                                const std::string &payload,
+                                const MessageProperties &properties) const
+{
+    for (auto id : ids) {
+        subscriptions_[id].handler(topic, payload, properties);
+    }
+    return ids.size();
+}
+
+} // namespace mqtt
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "mqtt_properties.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mqtt {
+
+// Маршрутизатор входящих сообщений по фильтрам подписок с поддержкой MQTT-масок '+' и '#'.
+// Фильтры хранятся в префиксном дереве по уровням топика, поэтому поиск обработчиков
+// занимает O(глубина топика) и не требует построения строк.
+// Потокобезопасность обеспечивает владелец (mqtt::Client).
+class TopicRouter
+{
+public:
+    using Handler = std::function<void(const std::string &topic,
+                                       const std::string &payload,
+                                       const MessageProperties &properties)>;
+    using SubscriptionId = std::uint32_t;
+
+    // Бросает std::invalid_argument для некорректного фильтра
+    SubscriptionId add(const std::string &filter, Handler handler);
+    bool remove(SubscriptionId id);
+    // Удалить все подписки на фильтр, возвращает количество удалённых
+    std::size_t remove(const std::string &filter);
+
+    // Вызывает все подходящие обработчики, возвращает их количество
+    std::size_t route(const std::string &topic,
+                      const std::string &payload,
+                      const MessageProperties &properties = {}) const;
+
+    // Уникальные фильтры активных подписок (для повторной подписки после переподключения)
+    std::vector<std::string> filters() const;
+
+    bool empty() const { return active_count_ == 0; }
+
+    static bool isValidFilter(std::string_view filter);
+
+private:
+    static constexpr std::uint32_t no_node = UINT32_MAX;
+
+    struct Node
+    {
+        // Дочерние узлы по точному имени уровня, отсортированы для бинарного поиска
+        std::vector<std::pair<std::string, std::uint32_t>> children;
+        std::uint32_t plus_child = no_node;
+        // Подписки, фильтр которых заканчивается на этом уровне
+        std::vector<SubscriptionId> exact;
+        // Подписки вида "<путь>/#", совпадающие с этим уровнем и всеми под ним
+        std::vector<SubscriptionId> multi;
+    };
+
+    struct Subscription
+    {
+        std::string filter;
+        Handler handler;
+        std::uint32_t node = no_node;
+        bool is_multi = false;
+    };
+
+    std::uint32_t childFor(std::uint32_t node, std::string_view level);
+    std::uint32_t findChild(std::uint32_t node, std::string_view level) const;
+    std::size_t match(std::uint32_t node,
+                      std::string_view rest,
+                      bool at_end,
+                      const std::string &topic,
+                      const std::string &payload,
+                      const MessageProperties &properties) const;
+    std::size_t invoke(const std::vector<SubscriptionId> &ids,
+                       const std::string &topic,
+                       const std::string &payload,
+                       const MessageProperties &properties) const;
+
+    std::vector<Node> nodes_{1};
+    std::vector<Subscription> subscriptions_;
+    std::vector<SubscriptionId> free_ids_;
+    std::size_t active_count_ = 0;
+};
+
+} // namespace mqtt
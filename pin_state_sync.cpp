@@ -0,0 +1,122 @@
+#include "pin_state_sync.hpp"
+#include <algorithm>
+#include <charconv>
+
+PinStateSync::PinStateSync(std::chrono::milliseconds snapshot_period,
+                           PublishFn publish,
+                           SnapshotFn snapshot,
+                           Clock::time_point now)
+    : snapshot_period_(snapshot_period)
+    , publish_(std::move(publish))
+    , snapshot_(std::move(snapshot))
+    , last_snapshot_(now)
+    , deltas_(reserved_pins)
+{
+    pending_.reserve(reserved_pins);
+    changes_.reserve(reserved_pins);
+    pins_.reserve(reserved_pins);
+    for (auto &delta : deltas_) {
+        delta.reserve(reserved_delta_size);
+    }
+}
+
+void PinStateSync::change(int pin, uint8_t value)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(pending_.begin(), pending_.end(), [pin](const auto &change) {
+        return change.first == pin;
+    });
+    if (it != pending_.end()) {
+        it->second = value;
+    } else {
+        pending_.emplace_back(pin, value);
+    }
+}
+
+void PinStateSync::requestSnapshot()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    snapshot_requested_ = true;
+}
+
+void PinStateSync::setSnapshotPeriod(std::chrono::milliseconds period)
+{
+    snapshot_period_ = period;
+}
+
+void PinStateSync::flush(Clock::time_point now)
+{
+    bool snapshot_due = now - last_snapshot_ >= snapshot_period_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        changes_.clear();
+        changes_.swap(pending_);
+        snapshot_due = snapshot_due || snapshot_requested_;
+        snapshot_requested_ = false;
+    }
+
+    if (changes_.empty() && !snapshot_due) {
+        return;
+    }
+
+    // Снимок, отправляемый всё равно, покрывает и накопленные изменения
+    if (snapshot_due) {
+        if (!changes_.empty()) {
+            ++sequence_;
+        }
+        publishSnapshot(snapshotPayload(sequence_), now);
+        return;
+    }
+
+    // Строки дельт сохраняют буферы между вызовами
+    if (deltas_.size() < changes_.size()) {
+        deltas_.resize(changes_.size());
+    }
+    std::size_t delta_bytes = 0;
+    for (std::size_t i = 0; i < changes_.size(); ++i) {
+        JsonDocument delta;
+        delta["seq"] = sequence_ + 1 + i;
+        delta["pin"] = changes_[i].first;
+        delta["value"] = changes_[i].second;
+        deltas_[i].assign(writer_.write(delta));
+        delta_bytes += deltas_[i].size();
+    }
+
+    // Одна дельта всегда короче снимка, сравнивать имеет смысл начиная с двух
+    if (changes_.size() > 1) {
+        const auto &snapshot = snapshotPayload(sequence_ + 1);
+        if (snapshot.size() <= delta_bytes) {
+            ++sequence_;
+            publishSnapshot(snapshot, now);
+            return;
+        }
+    }
+
+    for (std::size_t i = 0; i < changes_.size(); ++i) {
+        ++sequence_;
+        publish_(delta_topic, deltas_[i], false);
+    }
+}
+
+const std::string &PinStateSync::snapshotPayload(uint64_t sequence)
+{
+    JsonDocument data;
+    data["seq"] = sequence;
+    // Номер пина -> значение; роли пинов публикуются в embedded/config/state
+    auto &pins = data["pins"];
+    pins = Json::object();
+    snapshot_(pins_);
+    for (const auto &pin : pins_) {
+        // Номер пина как ключ умещается в SSO строки
+        char key[16];
+        char *end = std::to_chars(key, key + sizeof(key), pin.number).ptr;
+        pins[std::string(key, end)] = pin.value;
+    }
+    return writer_.write(data);
+}
+
+void PinStateSync::publishSnapshot(const std::string &payload, Clock::time_point now)
+{
+    publish_(snapshot_topic, payload, true);
+    last_snapshot_ = now;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "arena_json.hpp"
+#include "gpio/gpio_types.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Состояние пинов для подписчиков: изменения уходят дельтами с номером версии
+// в embedded/pins/state, полное состояние - сохраняемым (retained) снимком в
+// embedded/pins/snapshot. Новый подписчик сразу получает снимок от брокера, а по разрыву
+// в номерах дельт понимает, что пропустил изменения, и ждёт следующего снимка.
+// Вызывается из основного цикла, кроме change().
+class PinStateSync
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using PublishFn = std::function<void(const std::string &topic,
+                                         const std::string &payload,
+                                         bool retain)>;
+    // Заполняет вектор состоянием пинов, упорядоченным по номеру
+    using SnapshotFn = std::function<void(std::vector<gpio::PinSnapshot> &)>;
+
+    // Строки, а не литералы: временная std::string выделялась бы на каждую публикацию
+    static inline const std::string delta_topic = "embedded/pins/state";
+    static inline const std::string snapshot_topic = "embedded/pins/snapshot";
+
+    PinStateSync(std::chrono::milliseconds snapshot_period,
+                 PublishFn publish,
+                 SnapshotFn snapshot,
+                 Clock::time_point now = Clock::now());
+
+    // Потокобезопасно (колбэки записи приходят и из потока плавных переходов GPIO).
+    // Изменение копится до flush(), повторные изменения пина схлопываются.
+    void change(int pin, uint8_t value);
+    // Потокобезопасно: следующий flush() отправит снимок (подключение, переназначение пинов)
+    void requestSnapshot();
+    void setSnapshotPeriod(std::chrono::milliseconds period);
+
+    // Отправляет накопленные изменения - дельтами или одним снимком, если он короче, -
+    // и снимок по таймеру
+    void flush(Clock::time_point now = Clock::now());
+
+    uint64_t sequence() const { return sequence_; }
+
+private:
+    const std::string &snapshotPayload(uint64_t sequence);
+    void publishSnapshot(const std::string &payload, Clock::time_point now);
+
+    std::chrono::milliseconds snapshot_period_;
+    PublishFn publish_;
+    SnapshotFn snapshot_;
+    Clock::time_point last_snapshot_;
+
+    std::mutex mutex_;
+    std::vector<std::pair<int, uint8_t>> pending_;
+    bool snapshot_requested_ = false;
+
+    // Буфер изменений, обменивается с pending_ под мьютексом
+    std::vector<std::pair<int, uint8_t>> changes_;
+    // Номер версии: +1 на каждую дельту и на снимок, заменивший дельты
+    uint64_t sequence_ = 0;
+
+    // Буферы flush(), переиспользуемые между вызовами, чтобы публикация состояния
+    // после каждой команды не выделяла память. Начальная ёмкость - на reserved_pins пинов,
+    // на плате с большим числом буферы дорастут при первых изменениях.
+    static constexpr std::size_t reserved_pins = 16;
+    static constexpr std::size_t reserved_delta_size = 64;
+    std::vector<std::string> deltas_;
+    std::vector<gpio::PinSnapshot> pins_;
+    JsonWriter writer_;
+};
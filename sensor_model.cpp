@@ -0,0 +1,123 @@
+#include "sensor_model.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace {
+
+constexpr double seconds_per_day = 86400.0;
+constexpr unsigned fault_bits = 21;
+
+uint32_t faultThreshold(double probability)
+{
+    return static_cast<uint32_t>(std::clamp(probability, 0.0, 1.0) * (1u << fault_bits));
+}
+
+// Сумма двух равномерных из половин 64-битного числа, масштабированная до единичной
+// дисперсии: треугольное распределение вместо нормального, зато без log/sqrt/cos
+inline double unitNoise(uint64_t random)
+{
+    static constexpr double scale = 0x1.0p-32;
+    static constexpr double unit_variance = 2.449489742783178; // sqrt(6)
+    double sum = static_cast<double>(random >> 32) * scale
+                 + static_cast<double>(random & 0xffffffff) * scale;
+    return (sum - 1.0) * unit_variance;
+}
+
+} // namespace
+
+SensorBank::SensorBank(std::size_t count, const SensorModel &model, uint64_t seed)
+    : model_(model)
+    , stuck_threshold_(faultThreshold(model.stuck_probability))
+    , spike_threshold_(faultThreshold(model.spike_probability))
+    , dropout_threshold_(faultThreshold(model.dropout_probability))
+    , rng_(count, seed)
+    , walk_random_(count)
+    , noise_random_(count)
+    , fault_random_(count)
+    , offset_(count)
+    , walk_(count, 0.0)
+    , stuck_value_(count, 0.0f)
+    , stuck_left_(count, 0)
+{
+    rng_.next(walk_random_.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        offset_[i] = (xoshiro::toUnit(walk_random_[i]) * 2.0 - 1.0) * model_.offset_spread;
+    }
+}
+
+void SensorBank::generate(double time_of_day_s, float *out)
+{
+    const std::size_t count = size();
+    const double phase = 2.0 * std::numbers::pi
+                         * (time_of_day_s - model_.daily_peak_hour * 3600.0) / seconds_per_day;
+    const double common = model_.base + model_.daily_amplitude * std::cos(phase);
+    const double keep = 1.0 - model_.walk_reversion;
+
+    rng_.next(walk_random_.data());
+    rng_.next(noise_random_.data());
+    rng_.next(fault_random_.data());
+
+    // Плавная часть без ветвлений - векторизуемый цикл
+    const uint64_t *walk_random = walk_random_.data();
+    const uint64_t *noise_random = noise_random_.data();
+    double *walk = walk_.data();
+    const double *offset = offset_.data();
+    for (std::size_t i = 0; i < count; ++i) {
+        walk[i] = walk[i] * keep + model_.walk_sigma * unitNoise(walk_random[i]);
+        out[i] = static_cast<float>(common + offset[i] + walk[i]
+                                    + model_.noise * unitNoise(noise_random[i]));
+    }
+
+    // Отказы: три 21-битных числа из одного 64-битного, старший бит - знак выброса
+    static constexpr uint64_t fault_mask = (1u << fault_bits) - 1;
+    for (std::size_t i = 0; i < count; ++i) {
+        const uint64_t random = fault_random_[i];
+        const auto stuck = static_cast<uint32_t>(random & fault_mask);
+        const auto spike = static_cast<uint32_t>((random >> fault_bits) & fault_mask);
+        const auto dropout = static_cast<uint32_t>((random >> (2 * fault_bits)) & fault_mask);
+
+        if (stuck_left_[i] > 0) {
+            --stuck_left_[i];
+            out[i] = stuck_value_[i];
+        } else if (stuck < stuck_threshold_) {
+            stuck_left_[i] = model_.stuck_samples > 0 ? model_.stuck_samples - 1 : 0;
+            stuck_value_[i] = out[i];
+        }
+        if (spike < spike_threshold_) {
+            out[i] += static_cast<float>(random >> 63 ? model_.spike_magnitude
+                                                      : -model_.spike_magnitude);
+        }
+        if (dropout < dropout_threshold_) {
+            out[i] = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+}
+
+ModelTemperatureSensor::ModelTemperatureSensor(const SensorModel &model,
+                                               uint64_t seed,
+                                               std::shared_ptr<IClock> clock)
+    : bank_(1, model, seed)
+    , clock_(std::move(clock))
+    , last_value_(static_cast<int>(model.base))
+{}
+
+int ModelTemperatureSensor::getTemperatureTenthCelsius()
+{
+    return tryGetTemperatureTenthCelsius().value_or(last_value_);
+}
+
+std::optional<int> ModelTemperatureSensor::tryGetTemperatureTenthCelsius()
+{
+    auto since_epoch = std::chrono::duration<double>(clock_->wallNow().time_since_epoch());
+    float value = 0.0f;
+    bank_.generate(std::fmod(since_epoch.count(), seconds_per_day), &value);
+    if (std::isnan(value)) {
+        return std::nullopt;
+    }
+    last_value_ = static_cast<int>(std::lround(value));
+    return last_value_;
+}
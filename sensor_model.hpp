@@ -0,0 +1,84 @@
+#pragma once
+
+#include "clock.hpp"
+#include "temperature_sensor.hpp"
+#include "xoshiro.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Модель датчика температуры, значения в десятых °C:
+// среднее + суточный цикл + случайное блуждание с возвратом к среднему + шум измерения,
+// поверх - отказы с заданной вероятностью на отсчёт.
+struct SensorModel
+{
+    double base = 250.0;
+    // Разброс среднего между датчиками одного банка (равномерно в ±offset_spread)
+    double offset_spread = 0.0;
+    double daily_amplitude = 30.0;
+    double daily_peak_hour = 15.0;
+    // СКО шага блуждания и доля возврата к среднему за шаг
+    double walk_sigma = 2.0;
+    double walk_reversion = 0.01;
+    // СКО шума измерения
+    double noise = 1.5;
+
+    // Залипание: датчик выдаёт одно значение stuck_samples отсчётов подряд
+    double stuck_probability = 0.0005;
+    uint32_t stuck_samples = 60;
+    // Выброс: одиночный отсчёт, смещённый на ±spike_magnitude
+    double spike_probability = 0.001;
+    double spike_magnitude = 150.0;
+    // Пропуск: отсчёта нет (NaN)
+    double dropout_probability = 0.002;
+};
+
+// Банк виртуальных датчиков одной модели. Состояние хранится массивами, отсчёты
+// генерируются пачкой на все датчики сразу - без виртуального вызова на значение.
+class SensorBank
+{
+public:
+    SensorBank(std::size_t count, const SensorModel &model, uint64_t seed);
+
+    std::size_t size() const { return walk_.size(); }
+
+    // По отсчёту каждого датчика в out[0..size()), NaN - пропуск.
+    // time_of_day_s - секунды от полуночи UTC, задаёт фазу суточного цикла.
+    void generate(double time_of_day_s, float *out);
+
+private:
+    SensorModel model_;
+    // Пороги вероятностей отказов в единицах 21-битного случайного числа
+    uint32_t stuck_threshold_;
+    uint32_t spike_threshold_;
+    uint32_t dropout_threshold_;
+
+    xoshiro::Streams rng_;
+    std::vector<uint64_t> walk_random_;
+    std::vector<uint64_t> noise_random_;
+    std::vector<uint64_t> fault_random_;
+
+    std::vector<double> offset_;
+    std::vector<double> walk_;
+    std::vector<float> stuck_value_;
+    std::vector<uint32_t> stuck_left_;
+};
+
+// Датчик для Application на основе SensorBank из одного датчика, время суток берётся из clock
+class ModelTemperatureSensor : public TemperatureSensor
+{
+public:
+    ModelTemperatureSensor(const SensorModel &model, uint64_t seed, std::shared_ptr<IClock> clock);
+
+    // При пропуске возвращает последнее полученное значение
+    int getTemperatureTenthCelsius() override;
+    std::optional<int> tryGetTemperatureTenthCelsius() override;
+
+private:
+    SensorBank bank_;
+    std::shared_ptr<IClock> clock_;
+    int last_value_;
+};
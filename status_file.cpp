@@ -0,0 +1,24 @@
+#include "status_file.hpp"
+#include <cstdio>
+#include <fstream>
+
+StatusFile::StatusFile(std::string path)
+    : path_(std::move(path))
+    , temp_path_(path_ + ".tmp")
+{}
+
+StatusFile::~StatusFile()
+{
+    std::remove(path_.c_str());
+}
+
+bool StatusFile::write(const std::string &content)
+{
+    {
+        std::ofstream file(temp_path_, std::ios::trunc);
+        if (!(file << content << '\n')) {
+            return false;
+        }
+    }
+    return std::rename(temp_path_.c_str(), path_.c_str()) == 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+// Файл состояния для внешних проверок (healthcheck контейнера, systemd): содержимое
+// заменяется целиком через rename, поэтому читатель не видит частично записанный файл.
+// Время изменения файла служит признаком живости процесса. Удаляется в деструкторе.
+class StatusFile
+{
+public:
+    explicit StatusFile(std::string path);
+    ~StatusFile();
+
+    StatusFile(const StatusFile &) = delete;
+    StatusFile &operator=(const StatusFile &) = delete;
+
+    // false, если записать не удалось (ошибка не фатальна для приложения)
+    bool write(const std::string &content);
+
+private:
+    std::string path_;
+    std::string temp_path_;
+};
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <optional>
+
 class TemperatureSensor {
 public:
     virtual ~TemperatureSensor() = default;
     virtual int getTemperatureTenthCelsius() = 0;
+    // nullopt - отсчёта нет (отказ датчика); датчики без отказов всегда возвращают значение
+    virtual std::optional<int> tryGetTemperatureTenthCelsius()
+    {
+        return getTemperatureTenthCelsius();
+    }
 };
@@ -1,19 +1,22 @@
 #pragma once
 
 #include "temperature_sensor.hpp"
+#include <cstdint>
 #include <random>
 
 template<int MinTempTenthC, int MaxTempTenthC>
 class TemperatureSensorEmulator : public TemperatureSensor
 {
 public:
-    TemperatureSensorEmulator()
-        : dist_(MinTempTenthC, MaxTempTenthC)
+    // Фиксированный seed даёт воспроизводимую последовательность значений
+    explicit TemperatureSensorEmulator(uint32_t seed = std::random_device{}())
+        : gen_(seed)
+        , dist_(MinTempTenthC, MaxTempTenthC)
     {}
 
     int getTemperatureTenthCelsius() override { return dist_(gen_); }
 
 private:
-    std::mt19937 gen_{std::random_device{}()};
+    std::mt19937 gen_;
     std::uniform_int_distribution<int> dist_;
 };
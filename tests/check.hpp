@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+// Проверки тестов без фреймворка: CHECK печатает место и условие, не прерывая тест,
+// main возвращает check::result() - ненулевой код, если хоть одна проверка не прошла.
+namespace check {
+
+inline int failures = 0;
+
+inline int result()
+{
+    if (failures != 0) {
+        std::printf("%d check(s) failed\n", failures);
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+} // namespace check
+
+#define CHECK(condition)                                                                 \
+    do {                                                                                 \
+        if (!(condition)) {                                                              \
+            ++check::failures;                                                           \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);    \
+        }                                                                                \
+    } while (0)
@@ -0,0 +1,473 @@
+#pragma once
+
+#include "clock.hpp"
+#include "gpio/gpio_imanager.hpp"
+#include "mqtt/mqtt_iclient.hpp"
+#include "temperature_sensor.hpp"
+#include "topic_router.hpp"
+#include "trace.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Подделки внешних интерфейсов Application для тестов и нагрузочных прогонов
+namespace fakes {
+
+// Брокер в памяти: сообщения доставляются подпискам в потоке вызывающего, публикации
+// запоминаются. Колбэки подключения вызываются в потоке connect(), как из потока mosquitto.
+class MqttClient final : public mqtt::IClient
+{
+public:
+    struct Published
+    {
+        std::string topic;
+        std::string payload;
+        mqtt::PublishOptions options;
+    };
+
+    using PublishHook = std::function<void(const std::string &topic,
+                                           const std::string &payload,
+                                           const mqtt::PublishOptions &options)>;
+
+    void connect() override
+    {
+        std::chrono::milliseconds delay;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            delay = connect_delay_;
+        }
+        // Как разрешение имени и TCP-соединение у настоящего клиента
+        std::this_thread::sleep_for(delay);
+        ConnectCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++connects_;
+            if (fail_connect_) {
+                throw std::runtime_error("Broker unavailable");
+            }
+            connected_ = true;
+            callback = connect_callback_;
+        }
+        if (callback) {
+            callback();
+        }
+    }
+
+    void disconnect() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_ = false;
+    }
+
+    bool isConnected() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connected_;
+    }
+
+    void subscribe(const std::string &) override {}
+
+    void publish(const std::string &topic, const std::string &payload) override
+    {
+        publish(topic, payload, mqtt::PublishOptions{});
+    }
+
+    void publish(const std::string &topic,
+                 const std::string &payload,
+                 DeliveryCallback on_delivered) override
+    {
+        publish(topic, payload);
+        if (on_delivered) {
+            on_delivered(true);
+        }
+    }
+
+    void subscribe(const std::string &topic_filter, MessageCallback handler) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        router_.add(topic_filter,
+                    [handler](const std::string &topic,
+                              const std::string &payload,
+                              const mqtt::MessageProperties &) { handler(topic, payload); });
+    }
+
+    void unsubscribe(const std::string &topic_filter) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        router_.remove(topic_filter);
+    }
+
+    void subscribeRequests(const std::string &topic_filter, RequestCallback handler) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        router_.add(topic_filter, std::move(handler));
+    }
+
+    void publish(const std::string &topic,
+                 const std::string &payload,
+                 const mqtt::PublishOptions &options) override
+    {
+        PublishHook hook;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (record_published_) {
+                published_.push_back({topic, payload, options});
+            }
+            hook = publish_hook_;
+        }
+        published_cv_.notify_all();
+        if (hook) {
+            hook(topic, payload, options);
+        }
+    }
+
+    void setMessageCallback(MessageCallback) override {}
+
+    void setConnectCallback(ConnectCallback callback) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connect_callback_ = std::move(callback);
+    }
+
+    void setDisconnectCallback(DisconnectCallback callback) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        disconnect_callback_ = std::move(callback);
+    }
+
+    // Входящее сообщение от брокера; false - ни одной подходящей подписки
+    bool deliver(const std::string &topic,
+                 const std::string &payload,
+                 const mqtt::MessageProperties &properties = {})
+    {
+        // Как в mqtt::Client: трасса команды начинается при приёме
+        trace::Context trace_context(trace::newId());
+        trace::Scope span("mqtt.receive");
+        // Подписки меняются только до run(), маршрутизация под блокировкой не нужна
+        // и позволяет обработчикам публиковать
+        return router_.route(topic, payload, properties) != 0;
+    }
+
+    // Запрос MQTT 5 с response topic; ответ приложения или nullopt по таймауту
+    std::optional<std::string> request(const std::string &topic,
+                                       const std::string &payload,
+                                       std::chrono::milliseconds timeout
+                                       = std::chrono::seconds(5))
+    {
+        mqtt::MessageProperties properties;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            properties.response_topic = "test/reply/" + std::to_string(next_request_++);
+        }
+        const auto from = publishedCount();
+        deliver(topic, payload, properties);
+        auto reply = waitFor([&](const Published &message) {
+            return message.topic == properties.response_topic;
+        },
+                             timeout,
+                             from);
+        return reply ? std::optional<std::string>(reply->payload) : std::nullopt;
+    }
+
+    // Брокер разорвал соединение
+    void dropSession(int reason = 7)
+    {
+        DisconnectCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connected_ = false;
+            callback = disconnect_callback_;
+        }
+        if (callback) {
+            callback(reason);
+        }
+    }
+
+    // Первая публикация с номером не меньше from, для которой match вернул true
+    std::optional<Published> waitFor(const std::function<bool(const Published &)> &match,
+                                     std::chrono::milliseconds timeout,
+                                     std::size_t from = 0)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::optional<Published> found;
+        published_cv_.wait_for(lock, timeout, [&] {
+            for (std::size_t i = from; i < published_.size(); ++i) {
+                if (match(published_[i])) {
+                    found = published_[i];
+                    return true;
+                }
+            }
+            from = published_.size();
+            return false;
+        });
+        return found;
+    }
+
+    std::size_t publishedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return published_.size();
+    }
+
+    int connects() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connects_;
+    }
+
+    void setFailConnect(bool fail)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fail_connect_ = fail;
+    }
+
+    // connect() блокируется на delay, прежде чем подключиться или отказать
+    void setConnectDelay(std::chrono::milliseconds delay)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connect_delay_ = delay;
+    }
+
+    // Вызывается после каждой публикации в потоке публикующего, вне блокировки
+    void setPublishHook(PublishHook hook)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        publish_hook_ = std::move(hook);
+    }
+
+    // Без записи публикации видны только хуку, а сам клиент не выделяет память:
+    // для подсчёта выделений приложения и долгих прогонов
+    void setRecordPublished(bool record)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record_published_ = record;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable published_cv_;
+    mqtt::TopicRouter router_;
+    std::vector<Published> published_;
+    ConnectCallback connect_callback_;
+    DisconnectCallback disconnect_callback_;
+    PublishHook publish_hook_;
+    bool record_published_ = true;
+    bool connected_ = false;
+    bool fail_connect_ = false;
+    std::chrono::milliseconds connect_delay_{0};
+    int connects_ = 0;
+    unsigned next_request_ = 0;
+};
+
+// GPIO в памяти: плавный переход сразу записывает цель, антидребезга нет. Колбэки записи
+// вызываются под блокировкой, колбэк фронта - вне её, как в gpio::Manager.
+class Gpio final : public gpio::IManager
+{
+public:
+    void registerPin(const gpio::PinConfig &config) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Pin pin{config.type, config.mode, 0, gpio::EdgeMode::Rising, {}};
+        if (!pins_.emplace(config.number, pin).second) {
+            throw std::runtime_error("Pin already registered: " + std::to_string(config.number));
+        }
+    }
+
+    void unregisterPin(int pin_number) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pins_.erase(pin_number) == 0) {
+            throw std::runtime_error("Pin not registered: " + std::to_string(pin_number));
+        }
+    }
+
+    void writeDigitalPin(int pin_number, gpio::DigitalValue value) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        find(pin_number, gpio::PinType::Digital, gpio::PinMode::Output).value
+            = value == gpio::DigitalValue::High;
+        if (write_digital_) {
+            write_digital_(pin_number, value);
+        }
+    }
+
+    void writeAnalogPin(int pin_number, uint8_t value) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        find(pin_number, gpio::PinType::Analog, gpio::PinMode::Output).value = value;
+        if (write_analog_) {
+            write_analog_(pin_number, value);
+        }
+    }
+
+    void fadeAnalogPin(int pin_number,
+                       uint8_t target,
+                       std::chrono::milliseconds,
+                       gpio::Easing) override
+    {
+        writeAnalogPin(pin_number, target);
+    }
+
+    gpio::DigitalValue readDigitalPin(int pin_number) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return find(pin_number, gpio::PinType::Digital).value != 0 ? gpio::DigitalValue::High
+                                                                   : gpio::DigitalValue::Low;
+    }
+
+    uint8_t readAnalogPin(int pin_number) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return find(pin_number, gpio::PinType::Analog).value;
+    }
+
+    void snapshotInto(std::vector<gpio::PinSnapshot> &pins) override
+    {
+        pins.clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &[number, pin] : pins_) {
+            pins.push_back({number, pin.type, pin.mode, pin.value});
+        }
+    }
+
+    void injectAnalogValue(int pin_number, uint8_t value) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        find(pin_number, gpio::PinType::Analog, gpio::PinMode::Input).value = value;
+    }
+
+    void injectDigitalValue(int pin_number, gpio::DigitalValue value) override
+    {
+        EdgeCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto &pin = find(pin_number, gpio::PinType::Digital, gpio::PinMode::Input);
+            const uint8_t level = value == gpio::DigitalValue::High;
+            if (pin.value == level) {
+                return;
+            }
+            pin.value = level;
+            const bool rising = level != 0;
+            if (pin.edge_mode == gpio::EdgeMode::Both
+                || (pin.edge_mode == gpio::EdgeMode::Rising) == rising) {
+                callback = pin.on_edge;
+            }
+        }
+        if (callback) {
+            callback(pin_number, value);
+        }
+    }
+
+    void setEdgeCallback(int pin_number,
+                         gpio::EdgeMode mode,
+                         std::chrono::milliseconds,
+                         std::function<void(int, gpio::DigitalValue)> callback) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &pin = find(pin_number, gpio::PinType::Digital, gpio::PinMode::Input);
+        pin.edge_mode = mode;
+        pin.on_edge = std::move(callback);
+    }
+
+    void setWriteDigitalCallback(std::function<void(int, gpio::DigitalValue)> callback) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_digital_ = std::move(callback);
+    }
+
+    void setWriteAnalogCallback(std::function<void(int, uint8_t)> callback) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_analog_ = std::move(callback);
+    }
+
+private:
+    using EdgeCallback = std::function<void(int, gpio::DigitalValue)>;
+
+    struct Pin
+    {
+        gpio::PinType type;
+        gpio::PinMode mode;
+        uint8_t value = 0;
+        gpio::EdgeMode edge_mode = gpio::EdgeMode::Rising;
+        EdgeCallback on_edge;
+    };
+
+    Pin &find(int pin_number, gpio::PinType type)
+    {
+        auto it = pins_.find(pin_number);
+        if (it == pins_.end() || it->second.type != type) {
+            throw std::runtime_error("No such pin: " + std::to_string(pin_number));
+        }
+        return it->second;
+    }
+
+    Pin &find(int pin_number, gpio::PinType type, gpio::PinMode mode)
+    {
+        auto &pin = find(pin_number, type);
+        if (pin.mode != mode) {
+            throw std::runtime_error("Wrong pin mode: " + std::to_string(pin_number));
+        }
+        return pin;
+    }
+
+    std::mutex mutex_;
+    std::map<int, Pin> pins_;
+    std::function<void(int, gpio::DigitalValue)> write_digital_;
+    std::function<void(int, uint8_t)> write_analog_;
+};
+
+// Датчик с постоянным значением
+class TemperatureSensor final : public ::TemperatureSensor
+{
+public:
+    explicit TemperatureSensor(int tenth_celsius = 250)
+        : value_(tenth_celsius)
+    {}
+
+    int getTemperatureTenthCelsius() override { return value_; }
+
+private:
+    int value_;
+};
+
+// Реальное время, ускоренное в scale раз для таймеров приложения: лимиты частоты подписок
+// и команд не срабатывают на сотнях тысяч запросов в секунду, а ожидание событий остаётся
+// настоящим (пробуждение потока входит в замер)
+class ScaledClock final : public IClock
+{
+public:
+    explicit ScaledClock(int scale)
+        : scale_(scale)
+        , origin_(std::chrono::steady_clock::now())
+    {}
+
+    TimePoint now() const override
+    {
+        return origin_ + (std::chrono::steady_clock::now() - origin_) * scale_;
+    }
+
+    std::chrono::system_clock::time_point wallNow() const override
+    {
+        return std::chrono::system_clock::now();
+    }
+
+    void sleepFor(Duration duration) override { std::this_thread::sleep_for(duration / scale_); }
+
+    bool isRealTime() const override { return true; }
+
+private:
+    int scale_;
+    TimePoint origin_;
+};
+
+} // namespace fakes
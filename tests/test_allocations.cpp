@@ -0,0 +1,244 @@
+// Основной цикл в установившемся режиме не выделяет память в куче: после прогрева
+// команды с ответами, публикации температуры и снимки пинов обходятся без operator new.
+// Считаются выделения во всех потоках, в том числе при приёме сообщения. Ошибочные
+// команды сюда не входят: ответ и пачка ошибок с длинным текстом выделяют память.
+// Приём в настоящем mqtt::Client проверяется отдельно, через колбэк libmosquitto: свои
+// копии свойств libmosquitto делает через malloc, а не operator new, и они не считаются.
+#include "application.hpp"
+#include "check.hpp"
+#include "fakes.hpp"
+#include "gpio/gpio_manager.hpp"
+#include "mqtt_client.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mosquitto.h>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<std::size_t> allocations{0};
+
+using namespace std::chrono_literals;
+
+// Время приложения ускорено в clock_scale раз, чтобы лимиты частоты не отбрасывали команды;
+// температура и снимок пинов публикуются раз в 10 и 20 мс реального времени
+constexpr int clock_scale = 100000;
+
+const AppConfig config{.max_reconnect_attempts = 0,
+                       .button_debounce_ms = 50,
+                       .temperature_period_ms = 1000000,
+                       .reconnect_interval_ms = 100,
+                       .pin_snapshot_period_ms = 2000000,
+                       .pins = PinConfig{.red_pin = 3,
+                                         .green_pin = 5,
+                                         .blue_pin = 6,
+                                         .temperature_pin = 0,
+                                         .button_pin = 2,
+                                         .led_pin = 13},
+                       .config_file = {},
+                       .status_file = {}};
+
+struct Command
+{
+    std::string topic;
+    std::string payload;
+};
+
+const Command commands[] = {
+    {"embedded/control", R"({"command":"set_rgb","red":10,"green":20,"blue":30})"},
+    {"embedded/control", R"({"command":"set_pin","pin":13,"value":1})"},
+    {"embedded/pins/3/set", R"({"value":200})"},
+    {"embedded/control", R"({"command":"set_rgb","red":1,"green":2,"blue":3})"},
+    {"embedded/control", R"({"command":"set_pin","pin":13,"value":0})"},
+};
+
+// Лог приложения форматируется как обычно, но никуда не выводится
+class NullBuffer final : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+};
+
+} // namespace
+
+namespace mqtt {
+
+struct ClientTestAccess
+{
+    static void deliver(Client &client,
+                        const mosquitto_message &message,
+                        const mosquitto_property *properties)
+    {
+        Client::onMessageWrapper(nullptr, &client, &message, properties);
+    }
+};
+
+} // namespace mqtt
+
+namespace {
+
+// Команда с Response Topic и Correlation Data, как её отдаёт libmosquitto, проходит
+// Client::onMessage и маршрутизатор подписок без выделений после первого сообщения
+void checkClientReceive()
+{
+    mqtt::Client client("localhost", 1883, "test_allocations", "", "");
+    std::size_t handled = 0;
+    bool properties_seen = true;
+    client.subscribeRequests("embedded/control",
+                             [&](const std::string &,
+                                 const std::string &payload,
+                                 const mqtt::MessageProperties &properties) {
+                                 ++handled;
+                                 properties_seen = properties_seen && !payload.empty()
+                                                   && properties.response_topic == "test/reply"
+                                                   && properties.correlation_data.size() == 32;
+                             });
+
+    mosquitto_property *properties = nullptr;
+    mosquitto_property_add_string(&properties, MQTT_PROP_RESPONSE_TOPIC, "test/reply");
+    mosquitto_property_add_binary(&properties,
+                                  MQTT_PROP_CORRELATION_DATA,
+                                  "0123456789abcdef0123456789abcdef",
+                                  32);
+
+    std::string topic = commands[0].topic;
+    std::string payload = commands[0].payload;
+    mosquitto_message message{};
+    message.topic = topic.data();
+    message.payload = payload.data();
+    message.payloadlen = static_cast<int>(payload.size());
+
+    mqtt::ClientTestAccess::deliver(client, message, properties);
+    allocations = 0;
+    counting = true;
+    for (int i = 0; i < 1000; ++i) {
+        mqtt::ClientTestAccess::deliver(client, message, properties);
+    }
+    counting = false;
+    mosquitto_property_free_all(&properties);
+
+    CHECK(handled == 1001);
+    CHECK(properties_seen);
+    CHECK(allocations.load() == 0);
+    std::printf("heap allocations in Client::onMessage: %zu\n", allocations.load());
+}
+
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void *p = std::malloc(size != 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main()
+{
+    NullBuffer null_buffer;
+    auto *cout_buffer = std::cout.rdbuf(&null_buffer);
+    auto *cerr_buffer = std::cerr.rdbuf(&null_buffer);
+
+    auto mqtt_impl = std::make_unique<fakes::MqttClient>();
+    auto &mqtt = *mqtt_impl;
+    Application app(config,
+                    std::move(mqtt_impl),
+                    std::make_unique<gpio::Manager>(),
+                    std::make_unique<fakes::TemperatureSensor>(),
+                    nullptr,
+                    nullptr,
+                    std::make_shared<fakes::ScaledClock>(clock_scale));
+
+    // Ответ на команду - последняя её публикация: по счётчику ответов тест ждёт,
+    // пока основной цикл закончит команду. Первый снимок пинов - признак подключения.
+    // Хук копируется при каждой публикации: захват одного указателя не выделяет память
+    struct Published
+    {
+        const std::string reply_topic = "test/reply";
+        std::atomic<std::size_t> replies{0};
+        std::atomic<std::size_t> snapshots{0};
+    } published;
+    auto &replies = published.replies;
+    auto &snapshots = published.snapshots;
+    mqtt.setRecordPublished(false);
+    mqtt.setPublishHook(
+        [counters = &published](const std::string &topic, const std::string &, const auto &) {
+            if (topic == counters->reply_topic) {
+                counters->replies.fetch_add(1);
+            } else if (topic == PinStateSync::snapshot_topic) {
+                counters->snapshots.fetch_add(1);
+            }
+        });
+    mqtt::MessageProperties properties;
+    properties.response_topic = published.reply_topic;
+    properties.correlation_data = "0123456789abcdef0123456789abcdef";
+
+    std::thread runner([&app] { app.run(); });
+    const auto connect_deadline = std::chrono::steady_clock::now() + 5s;
+    while (snapshots.load() == 0 && std::chrono::steady_clock::now() < connect_deadline) {
+        std::this_thread::yield();
+    }
+    CHECK(snapshots.load() > 0);
+
+    auto send = [&](std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto &command = commands[i % std::size(commands)];
+            const auto expected = replies.load() + 1;
+            CHECK(mqtt.deliver(command.topic, command.payload, properties));
+            const auto deadline = std::chrono::steady_clock::now() + 5s;
+            while (replies.load() < expected && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+            if (replies.load() < expected) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Прогрев: буферы и арена доходят до рабочего размера, каждый слот очереди событий
+    // (их 256) хотя бы раз получает строки входящего сообщения
+    CHECK(send(1000));
+    std::this_thread::sleep_for(200ms);
+
+    counting = true;
+    const bool replied = send(2000);
+    counting = false;
+    CHECK(replied);
+    CHECK(allocations.load() == 0);
+    // Периодические публикации тоже прошли через замер
+    CHECK(snapshots.load() > 1);
+    std::printf("heap allocations in steady state: %zu\n", allocations.load());
+
+    mqtt.setFailConnect(true);
+    mqtt.dropSession();
+    runner.join();
+
+    checkClientReceive();
+
+    std::cout.rdbuf(cout_buffer);
+    std::cerr.rdbuf(cerr_buffer);
+    return check::result();
+}
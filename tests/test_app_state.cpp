@@ -0,0 +1,210 @@
+// Модельная проверка автомата состояния подключения: таблица app_transitions сверяется
+// с независимой спецификацией на всех парах (состояние, событие), AppStateMachine
+// и AppStateObserver - со спецификацией на всех чередованиях событий и снимков основного
+// цикла длиной до max_depth, счётчики входов - под одновременными post() из нескольких потоков
+#include "app_state.hpp"
+#include "check.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using S = AppState;
+using E = AppEvent;
+
+constexpr int max_depth = 7;
+
+// Намерение, изложенное заново, независимо от построения таблицы
+S spec(S state, E event)
+{
+    switch (state) {
+    case S::Exiting:
+        return state;
+    case S::Restarting:
+        if (event == E::ConnectionLost) {
+            return S::RestartingDisconnected;
+        }
+        if (event == E::RestartedOnline) {
+            return S::Connected;
+        }
+        return event == E::RestartedOffline ? S::Disconnected : state;
+    case S::RestartingDisconnected:
+        if (event == E::ConnectSucceeded) {
+            return S::Restarting;
+        }
+        // Сообщённое при выходе соединение уже разорвано
+        return event == E::RestartedOnline || event == E::RestartedOffline ? S::Disconnected
+                                                                           : state;
+    default:
+        break;
+    }
+
+    switch (event) {
+    case E::RestartRequested:
+        return S::Restarting;
+    case E::ConnectSucceeded:
+        return S::Connected;
+    case E::ConnectionLost:
+        return state == S::Connected || state == S::WaitingToConnect ? S::Disconnected : state;
+    case E::RetryDue:
+        return state == S::Disconnected ? S::Reconnecting : state;
+    case E::RetriesExhausted:
+        return state == S::Disconnected ? S::Exiting : state;
+    case E::ConnectStarted:
+        return state == S::Reconnecting ? S::WaitingToConnect : state;
+    case E::RestartedOnline:
+    case E::RestartedOffline:
+        return state;
+    }
+    return state;
+}
+
+// Шаг прогона: событие или снимок основного цикла (observe)
+constexpr std::size_t observe = app_event_count;
+
+long sequences = 0;
+
+// Все последовательности длиной depth после уже выбранных шагов sequence: события
+// вперемешку со снимками, которые основной цикл может сделать между любыми двумя post()
+void explore(std::vector<std::size_t> &sequence, int depth)
+{
+    if (depth == 0) {
+        ++sequences;
+        AppStateMachine machine(S::WaitingToConnect);
+        AppStateObserver observer(machine.snapshot());
+        S model = S::WaitingToConnect;
+        std::array<uint64_t, app_state_count> entered{};
+        std::array<uint64_t, app_state_count> entries{};
+        bool lost_during_restart = false;
+        for (const auto step : sequence) {
+            if (step == observe) {
+                // Снимок видит все входы с прошлого снимка, и ни одного - раньше состояния
+                const auto snapshot = machine.snapshot();
+                const bool changed = observer.update(snapshot);
+                CHECK(snapshot.state() == model);
+                bool any = false;
+                for (std::size_t state = 0; state < app_state_count; ++state) {
+                    CHECK(observer.entered(static_cast<S>(state)) == entered[state]);
+                    any = any || entered[state] != 0;
+                }
+                CHECK(changed == any);
+                entered.fill(0);
+                continue;
+            }
+
+            const auto event = static_cast<E>(step);
+            const S before = machine.state();
+            const S expected = spec(model, event);
+            const bool applied = machine.post(event);
+            CHECK(applied == (expected != model));
+            CHECK(machine.state() == expected);
+            model = expected;
+            if (applied) {
+                ++entered[static_cast<std::size_t>(model)];
+                ++entries[static_cast<std::size_t>(model)];
+            }
+
+            // Connected покидается только разрывом или перезапуском
+            if (before == S::Connected && model != S::Connected) {
+                CHECK(event == E::ConnectionLost || event == E::RestartRequested);
+            }
+            // Перезапуск заканчивается только своими событиями
+            if ((before == S::Restarting || before == S::RestartingDisconnected)
+                && model != S::Restarting && model != S::RestartingDisconnected) {
+                CHECK(event == E::RestartedOnline || event == E::RestartedOffline);
+            }
+            // Разрыв, последний за время перезапуска, переживает его окончание
+            if (before == S::Restarting || before == S::RestartingDisconnected) {
+                if (event == E::ConnectionLost) {
+                    lost_during_restart = true;
+                } else if (event == E::ConnectSucceeded) {
+                    lost_during_restart = false;
+                }
+            }
+            if (event == E::RestartedOnline && model != before && lost_during_restart) {
+                CHECK(model == S::Disconnected);
+            }
+            if (model != S::Restarting && model != S::RestartingDisconnected) {
+                lost_during_restart = false;
+            }
+        }
+
+        // Итоговый снимок догоняет все входы
+        observer.update(machine.snapshot());
+        for (std::size_t state = 0; state < app_state_count; ++state) {
+            CHECK(observer.entries(static_cast<S>(state)) == entries[state]);
+        }
+        return;
+    }
+    for (std::size_t step = 0; step <= observe; ++step) {
+        sequence.push_back(step);
+        explore(sequence, depth - 1);
+        sequence.pop_back();
+    }
+}
+
+} // namespace
+
+int main()
+{
+    for (std::size_t state = 0; state < app_state_count; ++state) {
+        for (std::size_t event = 0; event < app_event_count; ++event) {
+            const auto s = static_cast<S>(state);
+            const auto e = static_cast<E>(event);
+            if (appTransition(s, e) != spec(s, e)) {
+                std::printf("state %zu, event %zu: table and spec differ\n", state, event);
+                CHECK(appTransition(s, e) == spec(s, e));
+            }
+        }
+    }
+
+    std::vector<std::size_t> sequence;
+    for (int depth = 0; depth <= max_depth; ++depth) {
+        explore(sequence, depth);
+    }
+    std::printf("%ld sequences of events and snapshots checked\n", sequences);
+
+    // Переходы из нескольких потоков, снимки - между ними: ни один вход не теряется
+    // и не считается дважды
+    AppStateMachine machine(S::WaitingToConnect);
+    AppStateObserver observer(machine.snapshot());
+    std::mutex observer_mutex;
+    std::atomic<uint64_t> accepted{0};
+    std::vector<std::thread> posters;
+    for (unsigned seed = 0; seed < 4; ++seed) {
+        posters.emplace_back([&, seed] {
+            std::mt19937 random(seed);
+            uint64_t applied = 0;
+            for (int i = 0; i < 100000; ++i) {
+                auto event = static_cast<E>(random() % app_event_count);
+                // Exiting конечно: без этого события поток быстро упёрся бы в него
+                if (event == E::RetriesExhausted) {
+                    event = E::RetryDue;
+                }
+                applied += machine.post(event) ? 1 : 0;
+                // Снимок хотя бы раз на 2^entry_bits входов
+                std::lock_guard<std::mutex> lock(observer_mutex);
+                observer.update(machine.snapshot());
+            }
+            accepted += applied;
+        });
+    }
+    for (auto &poster : posters) {
+        poster.join();
+    }
+
+    observer.update(machine.snapshot());
+    uint64_t entries = 0;
+    for (std::size_t state = 0; state < app_state_count; ++state) {
+        entries += observer.entries(static_cast<S>(state));
+    }
+    CHECK(entries == accepted.load());
+
+    return check::result();
+}
@@ -0,0 +1,248 @@
+// Разбор JSON в арене (parseJson) сверяется с nlohmann::json::parse: принимаются и
+// отвергаются одни и те же документы, принятые сериализуются одинаково. Отдельно -
+// ограничение вложенности, суррогаты в \u и некорректный UTF-8 в строках: принятое
+// parseJson всегда сериализуется без исключений
+#include "arena_json.hpp"
+#include "check.hpp"
+
+#include <cstdio>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+long compared = 0;
+
+bool parses(const std::string &text)
+{
+    try {
+        static_cast<void>(parseJson(text));
+        return true;
+    } catch (const std::runtime_error &) {
+        return false;
+    }
+}
+
+// Строгий dump() nlohmann бросает на некорректном UTF-8
+bool dumps(const Json &value)
+{
+    try {
+        static_cast<void>(value.dump());
+        return true;
+    } catch (const nlohmann::json::exception &) {
+        return false;
+    }
+}
+
+// Принимает ли parseJson документ так же, как nlohmann, и с тем же результатом.
+// nlohmann считает нулевой байт концом ввода; parseJson такой документ отвергает
+bool sameAsNlohmann(const std::string &text)
+{
+    ++compared;
+    const bool accepted = text.find('\0') == std::string::npos && nlohmann::json::accept(text);
+    Json value;
+    try {
+        value = parseJson(text);
+    } catch (const std::runtime_error &) {
+        return !accepted;
+    }
+    if (!accepted || !dumps(value)) {
+        return false;
+    }
+    JsonWriter writer;
+    return writer.write(value) == nlohmann::json::parse(text).dump();
+}
+
+std::string nested(int depth, const char *open, const char *close)
+{
+    std::string text;
+    for (int i = 0; i < depth; ++i) {
+        text += open;
+    }
+    text += "0";
+    for (int i = 0; i < depth; ++i) {
+        text += close;
+    }
+    return text;
+}
+
+void checkDocuments()
+{
+    const char *documents[] = {
+        R"({"command":"set_rgb","red":10,"green":20,"blue":30})",
+        R"({"a":[1,-2,3.5,1e3,-0,0.0,true,false,null],"b":{"c":"d"}})",
+        R"({"a":1,"a":2})",
+        R"(  [ ]  )",
+        R"("\"\\\/\b\f\n\r\t")",
+        R"(18446744073709551615)",
+        R"(18446744073709551616)",
+        R"(-9223372036854775808)",
+        R"(-9223372036854775809)",
+        R"(1e400)",
+        R"(1e-400)",
+        R"(01)",
+        R"(1.)",
+        R"(-)",
+        R"(+1)",
+        R"(.5)",
+        R"(1e)",
+        R"([1,])",
+        R"({"a":1,})",
+        R"({"a" 1})",
+        R"({1:2})",
+        R"([1 2])",
+        R"(tru)",
+        R"(nul)",
+        R"("abc)",
+        R"("\x")",
+        R"("\u12")",
+        R"("\u12G4")",
+        R"("\u-123")",
+        R"("\u+123")",
+        "\"a\tb\"",
+        "[1]x",
+        "",
+        " ",
+    };
+    for (const char *document : documents) {
+        if (!sameAsNlohmann(document)) {
+            std::printf("differs from nlohmann: %s\n", document);
+            CHECK(false);
+        }
+    }
+}
+
+// Контейнеры вложены не глубже 64 уровней; глубже - ошибка разбора, а не переполнение стека
+void checkDepth()
+{
+    CHECK(parses(nested(64, "[", "]")));
+    CHECK(!parses(nested(65, "[", "]")));
+    CHECK(parses(nested(64, "{\"a\":", "}")));
+    CHECK(!parses(nested(65, "{\"a\":", "}")));
+    CHECK(parses(nested(32, "[{\"a\":", "}]")));
+    CHECK(!parses("[" + nested(32, "[{\"a\":", "}]") + "]"));
+    CHECK(!parses(nested(100000, "[", "]")));
+    CHECK(!parses(std::string(100000, '[')));
+    // Глубина считается по вложенности, а не по числу контейнеров
+    std::string wide = "[";
+    for (int i = 0; i < 1000; ++i) {
+        wide += nested(60, "[", "]") + ",";
+    }
+    wide += "0]";
+    CHECK(parses(wide));
+}
+
+// Суррогаты в \u: пара даёт один символ вне BMP, одиночные половины и пары
+// не в том порядке отвергаются
+void checkSurrogates()
+{
+    const auto pair = parseJson(R"("\ud83d\ude00")");
+    CHECK(pair.get<std::string>() == "\xf0\x9f\x98\x80");
+    CHECK(parseJson(R"("\uDBFF\uDFFF")").get<std::string>() == "\xf4\x8f\xbf\xbf");
+
+    const char *units[] = {"d800", "dbff", "dc00", "dfff", "0041", "ffff", "0000"};
+    for (const char *first : units) {
+        const std::string lone = std::string("\"\\u") + first + "\"";
+        CHECK(sameAsNlohmann(lone));
+        CHECK(sameAsNlohmann(std::string("\"\\u") + first + "x\""));
+        CHECK(sameAsNlohmann(std::string("\"\\u") + first + "\\n\""));
+        for (const char *second : units) {
+            CHECK(sameAsNlohmann(std::string("\"\\u") + first + "\\u" + second + "\""));
+        }
+    }
+    CHECK(!parses(R"("\ud800")"));
+    CHECK(!parses(R"("\udc00")"));
+    CHECK(!parses(R"("\ud800\u0041")"));
+    CHECK(!parses(R"("\ude00\ud83d")"));
+    CHECK(!parses(R"("\ud800\")"));
+}
+
+// Байты строки: все последовательности из одного и двух байт, трёх и четырёх - с
+// граничными значениями продолжений. Принятое совпадает с nlohmann и сериализуется строго
+void checkUtf8()
+{
+    CHECK(!parses("\"\xff\""));
+    CHECK(!parses("\"\x80\""));
+    CHECK(!parses("\"\xc0\xaf\""));
+    CHECK(!parses("\"\xe0\x80\xaf\""));
+    CHECK(!parses("\"\xed\xa0\x80\""));
+    CHECK(!parses("\"\xf4\x90\x80\x80\""));
+    CHECK(!parses("\"\xc3\""));
+    CHECK(!parses("{\"\xc3\":1}"));
+    CHECK(parses("\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\""));
+
+    int mismatches = 0;
+    std::string text = "\"..\"";
+    for (int first = 0; first < 256; ++first) {
+        for (int second = 0; second < 256; ++second) {
+            text.resize(3);
+            text[1] = static_cast<char>(first);
+            text[2] = static_cast<char>(second);
+            text += '"';
+            mismatches += sameAsNlohmann(text) ? 0 : 1;
+            text.resize(3);
+            text += 'x';
+            text += '"';
+            mismatches += sameAsNlohmann(text) ? 0 : 1;
+        }
+    }
+    const int edges[] = {0x00, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf, 0xc0, 0xff};
+    text = "\"...\"";
+    for (int first = 0xC0; first < 0x100; ++first) {
+        for (int second = 0; second < 256; ++second) {
+            for (const int third : edges) {
+                text[1] = static_cast<char>(first);
+                text[2] = static_cast<char>(second);
+                text[3] = static_cast<char>(third);
+                mismatches += sameAsNlohmann(text) ? 0 : 1;
+            }
+        }
+    }
+    text = "\"....\"";
+    for (int first = 0xF0; first < 0x100; ++first) {
+        for (const int second : edges) {
+            for (const int third : edges) {
+                for (const int fourth : edges) {
+                    text[1] = static_cast<char>(first);
+                    text[2] = static_cast<char>(second);
+                    text[3] = static_cast<char>(third);
+                    text[4] = static_cast<char>(fourth);
+                    mismatches += sameAsNlohmann(text) ? 0 : 1;
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+// Строки, собранные не разбором (топики, текст от брокера), сериализуются
+// с заменой некорректных байтов на U+FFFD
+void checkWriterReplaces()
+{
+    Json value = Json::object();
+    value["topic"] = "embedded/pins/\xff\xc3/set";
+    JsonWriter writer;
+    bool written = true;
+    std::string output;
+    try {
+        output = writer.write(value);
+    } catch (const nlohmann::json::exception &) {
+        written = false;
+    }
+    CHECK(written);
+    CHECK(output == "{\"topic\":\"embedded/pins/\xef\xbf\xbd\xef\xbf\xbd/set\"}");
+}
+
+} // namespace
+
+int main()
+{
+    checkDocuments();
+    checkDepth();
+    checkSurrogates();
+    checkUtf8();
+    checkWriterReplaces();
+    std::printf("%ld documents compared with nlohmann\n", compared);
+    return check::result();
+}
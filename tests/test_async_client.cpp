@@ -0,0 +1,139 @@
+// Корутинный API поверх IClient: co_await connect() не останавливает планировщик, пока
+// connect() блокируется в фоне, publish() завершается подтверждением, входящие сообщения
+// приходят потоком по одному на co_await. Тела задач выполняются в потоке планировщика
+#include "check.hpp"
+#include "fakes.hpp"
+#include "mqtt_async_client.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+struct Run
+{
+    std::thread::id scheduler_thread = std::this_thread::get_id();
+    bool off_thread = false;
+    bool connected = false;
+    int ticks_while_connecting = 0;
+    bool published = false;
+    // Подделка маршрутизирует без блокировки: брокер начинает после подписки
+    std::atomic<bool> subscribed{false};
+    std::vector<mqtt::Message> received;
+    std::string connect_error;
+
+    void onSchedulerThread()
+    {
+        off_thread = off_thread || std::this_thread::get_id() != scheduler_thread;
+    }
+};
+
+async::Task<> session(mqtt::AsyncClient &client, Run &run)
+{
+    co_await client.connect();
+    run.onSchedulerThread();
+    run.connected = true;
+
+    co_await client.publish("embedded/pins/state", R"({"pins":[]})");
+    run.onSchedulerThread();
+    run.published = true;
+
+    client.subscribe("embedded/pins/+/set");
+    run.subscribed = true;
+    for (int i = 0; i < 3; ++i) {
+        run.received.push_back(co_await client.nextMessage());
+        run.onSchedulerThread();
+    }
+}
+
+// Соседняя задача: пока connect() висит в фоне, планировщик продолжает её возобновлять
+async::Task<> ticker(async::Scheduler &scheduler, Run &run)
+{
+    while (!run.connected) {
+        co_await scheduler.sleepFor(10ms);
+        run.onSchedulerThread();
+        ++run.ticks_while_connecting;
+    }
+}
+
+async::Task<> failingConnect(mqtt::AsyncClient &client, Run &run)
+{
+    try {
+        co_await client.connect();
+    } catch (const std::runtime_error &e) {
+        run.connect_error = e.what();
+    }
+    run.onSchedulerThread();
+}
+
+} // namespace
+
+int main()
+{
+    {
+        fakes::MqttClient mqtt;
+        mqtt.setConnectDelay(300ms);
+        async::Scheduler scheduler;
+        mqtt::AsyncClient client(mqtt, scheduler);
+        Run run;
+
+        scheduler.spawn(session(client, run));
+        scheduler.spawn(ticker(scheduler, run));
+
+        // Брокер присылает сообщения из своего потока, в том числе не по подписке
+        std::thread broker([&] {
+            while (!run.subscribed) {
+                std::this_thread::sleep_for(1ms);
+            }
+            for (const char *topic : {"embedded/pins/3/set",
+                                      "embedded/other",
+                                      "embedded/pins/5/set",
+                                      "embedded/pins/6/set"}) {
+                mqtt.deliver(topic, topic);
+            }
+        });
+        scheduler.run();
+        broker.join();
+
+        CHECK(run.connected);
+        CHECK(mqtt.isConnected());
+        // 300 мс фонового подключения - около 30 тиков по 10 мс
+        CHECK(run.ticks_while_connecting >= 10);
+        CHECK(run.published);
+        CHECK(mqtt.publishedCount() == 1);
+        CHECK(run.received.size() == 3);
+        if (run.received.size() == 3) {
+            CHECK(run.received[0].topic == "embedded/pins/3/set");
+            CHECK(run.received[1].topic == "embedded/pins/5/set");
+            CHECK(run.received[2].payload == "embedded/pins/6/set");
+        }
+        CHECK(!run.off_thread);
+        std::printf("scheduler ticks during a 300 ms connect: %d\n", run.ticks_while_connecting);
+    }
+
+    {
+        fakes::MqttClient mqtt;
+        mqtt.setFailConnect(true);
+        async::Scheduler scheduler;
+        mqtt::AsyncClient client(mqtt, scheduler);
+        Run run;
+
+        scheduler.spawn(failingConnect(client, run));
+        scheduler.run();
+
+        // Исключение из фонового connect() доходит до ожидающей корутины
+        CHECK(run.connect_error == "Broker unavailable");
+        CHECK(!run.off_thread);
+    }
+
+    return check::result();
+}
@@ -0,0 +1,69 @@
+// Пачка ошибок с деталью из внешнего текста: длинная деталь не в ASCII обрезается
+// по границе символа, некорректный UTF-8 заменяется, публикация не бросает исключений
+#include "check.hpp"
+#include "error_reporter.hpp"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace {
+
+// Строгий dump() nlohmann бросает на некорректном UTF-8
+bool validUtf8(const std::string &text)
+{
+    try {
+        static_cast<void>(nlohmann::json(text).dump());
+        return true;
+    } catch (const nlohmann::json::exception &) {
+        return false;
+    }
+}
+
+} // namespace
+
+int main()
+{
+    std::string published;
+    int batches = 0;
+    ErrorReporter reporter(std::chrono::milliseconds(0), [&](const std::string &payload) {
+        published = payload;
+        ++batches;
+    });
+
+    // Имя команды из {"command":"a" + 100 "é"}: граница обрезки делит двухбайтовый символ
+    std::string command = "a";
+    for (int i = 0; i < 100; ++i) {
+        command += "\xc3\xa9";
+    }
+    reporter.report(ErrorCode::UnsupportedCommand, command);
+    // Топик - произвольные байты от брокера
+    reporter.report(ErrorCode::InvalidPinTopic, "embedded/pins/\xff\xfe/set");
+
+    bool published_ok = true;
+    try {
+        reporter.flush();
+    } catch (const std::exception &) {
+        published_ok = false;
+    }
+    CHECK(published_ok);
+    CHECK(batches == 1);
+
+    const auto batch = nlohmann::json::parse(published, nullptr, false);
+    CHECK(!batch.is_discarded());
+    if (batch.is_discarded()) {
+        return check::result();
+    }
+    for (const auto &error : batch["errors"]) {
+        const auto detail = error["detail"].get<std::string>();
+        CHECK(validUtf8(detail));
+        if (error["code"] == static_cast<int>(ErrorCode::UnsupportedCommand)) {
+            CHECK(detail.size() <= ErrorReporter::max_detail_length);
+            CHECK(detail.size() > ErrorReporter::max_detail_length - 2);
+            CHECK(detail.rfind("a\xc3\xa9", 0) == 0);
+        }
+    }
+    CHECK(batch["errors"].size() == 2);
+
+    return check::result();
+}
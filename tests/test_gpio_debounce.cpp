@@ -0,0 +1,53 @@
+// Антидребезг цифрового входа: колбэк подавляется внутри окна, уровень пина - нет
+#include "check.hpp"
+#include "gpio_manager.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace {
+
+using gpio::DigitalValue;
+
+constexpr int button_pin = 2;
+// С запасом, чтобы переходы подряд без пауз гарантированно попадали в окно
+constexpr auto debounce = std::chrono::milliseconds(200);
+constexpr auto past_window = debounce + std::chrono::milliseconds(50);
+
+} // namespace
+
+int main()
+{
+    gpio::Manager manager;
+    manager.registerPin({button_pin, gpio::PinType::Digital, gpio::PinMode::Input});
+
+    int presses = 0;
+    manager.setEdgeCallback(button_pin,
+                            gpio::EdgeMode::Rising,
+                            debounce,
+                            [&presses](int, DigitalValue) { ++presses; });
+
+    // Нажатие с дребезгом: один колбэк, но пин отражает последний уровень
+    manager.injectDigitalValue(button_pin, DigitalValue::High);
+    manager.injectDigitalValue(button_pin, DigitalValue::Low);
+    manager.injectDigitalValue(button_pin, DigitalValue::High);
+    manager.injectDigitalValue(button_pin, DigitalValue::Low);
+    CHECK(presses == 1);
+    CHECK(manager.readDigitalPin(button_pin) == DigitalValue::Low);
+
+    // Отпускание попало в окно; следующее нажатие после окна не теряется
+    std::this_thread::sleep_for(past_window);
+    manager.injectDigitalValue(button_pin, DigitalValue::High);
+    CHECK(presses == 2);
+    CHECK(manager.readDigitalPin(button_pin) == DigitalValue::High);
+
+    // Отпускание после окна - принятый спад без колбэка, затем нажатие
+    std::this_thread::sleep_for(past_window);
+    manager.injectDigitalValue(button_pin, DigitalValue::Low);
+    CHECK(presses == 2);
+    std::this_thread::sleep_for(past_window);
+    manager.injectDigitalValue(button_pin, DigitalValue::High);
+    CHECK(presses == 3);
+
+    return check::result();
+}
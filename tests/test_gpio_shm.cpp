@@ -0,0 +1,59 @@
+// Зеркало таблицы пинов: согласованное чтение и ограниченное ожидание зависшего писателя
+#include "check.hpp"
+#include "gpio_manager.hpp"
+#include "gpio_shm_reader.hpp"
+
+#include <chrono>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const std::string shm_name = "/embedded_gpio_test_" + std::to_string(getpid());
+
+} // namespace
+
+int main()
+{
+    gpio::Manager manager;
+    manager.registerPin({3, gpio::PinType::Analog, gpio::PinMode::Output});
+    manager.registerPin({13, gpio::PinType::Digital, gpio::PinMode::Output});
+    manager.exportStateToSharedMemory(shm_name);
+    manager.writeAnalogPin(3, 77);
+
+    gpio::ShmStateReader reader(shm_name);
+    gpio::ShmStateReader::Snapshot snapshot;
+    CHECK(reader.read(snapshot));
+    CHECK(snapshot.count == 2);
+    auto pin = reader.readPin(3);
+    CHECK(pin && pin->value == 77);
+    CHECK(!reader.readPin(4));
+
+    // Писатель завершился посреди записи: sequence остаётся нечётным
+    int fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+    CHECK(fd >= 0);
+    void *addr = mmap(
+        nullptr, sizeof(gpio::shm::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    CHECK(addr != MAP_FAILED);
+    auto *segment = static_cast<gpio::shm::Segment *>(addr);
+    segment->sequence.fetch_add(1);
+
+    const auto timeout = std::chrono::milliseconds(20);
+    const auto started = std::chrono::steady_clock::now();
+    CHECK(!reader.read(snapshot, timeout));
+    const auto waited = std::chrono::steady_clock::now() - started;
+    CHECK(waited >= timeout);
+    CHECK(waited < std::chrono::seconds(1));
+    CHECK(!reader.readPin(3));
+
+    // Писатель восстановился - чтение снова проходит
+    segment->sequence.fetch_add(1);
+    CHECK(reader.read(snapshot));
+    CHECK(reader.readPin(3));
+
+    munmap(addr, sizeof(gpio::shm::Segment));
+    close(fd);
+    return check::result();
+}
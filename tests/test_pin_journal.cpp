@@ -0,0 +1,88 @@
+// Журнал пинов при ошибке записи: пачка, упёршаяся в RLIMIT_FSIZE, отрезается от файла,
+// flush() сообщает о неудаче, а после снятия лимита записи дописываются повтором
+// без потерь и без обрывков в середине файла
+#include "check.hpp"
+#include "pin_journal.hpp"
+
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::uintmax_t header_size = 16;
+constexpr std::uintmax_t record_size = 12;
+
+// Размер файла - заголовок и целое число записей
+bool wholeRecords(std::uintmax_t size)
+{
+    return size >= header_size && (size - header_size) % record_size == 0;
+}
+
+void limitFileSize(rlim_t size)
+{
+    rlimit limit{};
+    getrlimit(RLIMIT_FSIZE, &limit);
+    limit.rlim_cur = size;
+    setrlimit(RLIMIT_FSIZE, &limit);
+}
+
+} // namespace
+
+int main()
+{
+    std::cerr.setstate(std::ios::failbit);
+    // Превышение лимита - EFBIG от write вместо завершения процесса
+    std::signal(SIGXFSZ, SIG_IGN);
+    rlimit original{};
+    getrlimit(RLIMIT_FSIZE, &original);
+
+    const auto path = std::filesystem::temp_directory_path()
+                      / ("test_pin_journal_" + std::to_string(getpid()));
+    std::filesystem::remove(path);
+
+    {
+        journal::PinJournal journal(path);
+        journal.record(1, 10);
+        CHECK(journal.flush());
+        const auto committed = std::filesystem::file_size(path);
+        CHECK(committed == header_size + record_size);
+
+        // Места - на полторы записи: пачка обрывается посреди второй
+        limitFileSize(committed + record_size + record_size / 2);
+        for (int pin = 2; pin <= 6; ++pin) {
+            journal.record(pin, static_cast<uint8_t>(pin * 10));
+        }
+        CHECK(!journal.flush());
+        CHECK(journal.stats().failed_commits > 0);
+        CHECK(wholeRecords(std::filesystem::file_size(path)));
+
+        limitFileSize(original.rlim_cur);
+        CHECK(journal.flush());
+    }
+
+    // Каждая запись ровно один раз, хвостов от неудачных попыток нет
+    CHECK(std::filesystem::file_size(path) == header_size + 6 * record_size);
+    {
+        journal::PinJournal journal(path);
+        const auto state = journal.state();
+        CHECK(state.size() == 6);
+        for (int pin = 1; pin <= 6; ++pin) {
+            CHECK(state.count(pin) == 1 && state.at(pin) == pin * 10);
+        }
+
+        // Диск не освободился до остановки: после последней попытки записи отбрасываются,
+        // деструктор не зависает, файл остаётся целым
+        limitFileSize(std::filesystem::file_size(path) + record_size / 2);
+        journal.record(7, 70);
+    }
+    limitFileSize(original.rlim_cur);
+    CHECK(std::filesystem::file_size(path) == header_size + 6 * record_size);
+    CHECK(journal::PinJournal(path).state().count(7) == 0);
+
+    std::filesystem::remove(path);
+    return check::result();
+}
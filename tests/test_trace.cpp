@@ -0,0 +1,93 @@
+// Буфер трассы: выгрузка во время записи не видит разорванных интервалов,
+// сводка считает command.total только по трассам с id
+#include "check.hpp"
+#include "trace.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Поля интервала согласованы между собой: разрыв виден при любой смеси двух записей
+trace::Span makeSpan(uint64_t n)
+{
+    return {"test.span",
+            n,
+            static_cast<int64_t>(n * 3),
+            static_cast<int64_t>(n * 3 + 1)};
+}
+
+bool consistent(const trace::Span &span)
+{
+    return std::string(span.name) == "test.span"
+           && span.start_ns == static_cast<int64_t>(span.id * 3)
+           && span.end_ns == span.start_ns + 1;
+}
+
+} // namespace
+
+int main()
+{
+    trace::enable(true);
+
+    // Запись в буфер без пауз, выгрузки из другого потока
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> written{0};
+    std::thread writer([&stop, &written] {
+        for (uint64_t n = 1; !stop.load(std::memory_order_relaxed); ++n) {
+            const auto span = makeSpan(n);
+            trace::record(span.name, span.id, span.start_ns, span.end_ns);
+            written.store(n, std::memory_order_relaxed);
+        }
+    });
+    // Кольцо заполнено: дальше каждая запись перезаписывает слот
+    while (written.load(std::memory_order_relaxed) < trace::Buffer::capacity) {
+        std::this_thread::yield();
+    }
+
+    std::size_t collected = 0;
+    std::size_t torn = 0;
+    std::size_t out_of_order = 0;
+    for (int round = 0; round < 2000; ++round) {
+        for (const auto &thread : trace::collect()) {
+            uint64_t previous = 0;
+            for (const auto &span : thread.spans) {
+                ++collected;
+                torn += !consistent(span);
+                out_of_order += span.id <= previous;
+                previous = span.id;
+            }
+        }
+    }
+    stop = true;
+    writer.join();
+
+    CHECK(collected > 0);
+    CHECK(torn == 0);
+    CHECK(out_of_order == 0);
+
+    // После остановки писателя в буфере ровно capacity последних интервалов
+    auto threads = trace::collect();
+    CHECK(threads.size() == 1);
+    CHECK(!threads.empty() && threads.front().spans.size() == trace::Buffer::capacity);
+
+    // Интервалы без id не образуют command.total
+    trace::Thread spans{1,
+                        {{"a", 7, 100, 200},
+                         {"b", 7, 150, 400},
+                         {"a", 8, 1000, 1100},
+                         {"loop", 0, 0, 1000000}}};
+    std::size_t totals = 0;
+    for (const auto &stats : trace::summarize({spans})) {
+        if (stats.name == "command.total") {
+            totals = stats.count;
+            CHECK(stats.max_us == 0.3);
+        }
+    }
+    CHECK(totals == 2);
+
+    return check::result();
+}
@@ -0,0 +1,130 @@
+// Тёплый перезапуск: выходы сохраняются, живая сессия не переподключается, а разорванная
+// во время перезапуска восстанавливается. Печатает время перезапуска.
+#include "application.hpp"
+#include "check.hpp"
+#include "fakes.hpp"
+#include "gpio/gpio_manager.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+// Одна попытка переподключения с коротким интервалом: отказ брокера быстро завершает run()
+const AppConfig config{.max_reconnect_attempts = 1,
+                       .button_debounce_ms = 50,
+                       .temperature_period_ms = 60000,
+                       .reconnect_interval_ms = 100,
+                       .pin_snapshot_period_ms = 30000,
+                       .pins = PinConfig{.red_pin = 3,
+                                         .green_pin = 5,
+                                         .blue_pin = 6,
+                                         .temperature_pin = 0,
+                                         .button_pin = 2,
+                                         .led_pin = 13},
+                       .config_file = {},
+                       .status_file = {}};
+
+const std::string led_on = R"({"command":"set_pin","pin":13,"value":1})";
+const std::string warm_restart = R"({"command":"restart","mode":"warm"})";
+
+bool isOk(const std::optional<std::string> &reply)
+{
+    return reply && reply->find("\"ok\"") != std::string::npos;
+}
+
+// Снимок пинов публикуется первым после каждого подключения
+bool waitForSnapshot(fakes::MqttClient &mqtt, std::size_t from)
+{
+    return mqtt
+        .waitFor([](const auto &message) { return message.topic == PinStateSync::snapshot_topic; },
+                 5s,
+                 from)
+        .has_value();
+}
+
+bool outputsKept(gpio::Manager &gpio)
+{
+    return gpio.readAnalogPin(3) == 10 && gpio.readAnalogPin(5) == 20
+           && gpio.readAnalogPin(6) == 30 && gpio.readDigitalPin(13) == gpio::DigitalValue::High;
+}
+
+long microsecondsSince(Clock::time_point started)
+{
+    return static_cast<long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count());
+}
+
+} // namespace
+
+int main()
+{
+    std::cout.setstate(std::ios::failbit);
+    std::cerr.setstate(std::ios::failbit);
+
+    auto mqtt_impl = std::make_unique<fakes::MqttClient>();
+    auto gpio_impl = std::make_unique<gpio::Manager>();
+    auto &mqtt = *mqtt_impl;
+    auto &gpio = *gpio_impl;
+    Application app(config,
+                    std::move(mqtt_impl),
+                    std::move(gpio_impl),
+                    std::make_unique<fakes::TemperatureSensor>());
+    std::thread runner([&app] { app.run(); });
+
+    CHECK(waitForSnapshot(mqtt, 0));
+    CHECK(isOk(mqtt.request("embedded/control",
+                            R"({"command":"set_rgb","red":10,"green":20,"blue":30})")));
+    CHECK(isOk(mqtt.request("embedded/control", led_on)));
+    CHECK(outputsKept(gpio));
+
+    // Обычный запрос - для сравнения со временем запроса через перезапуск
+    auto started = Clock::now();
+    CHECK(isOk(mqtt.request("embedded/control", led_on)));
+    const long request_us = microsecondsSince(started);
+
+    // Запрос после команды перезапуска обрабатывается, когда перезапуск завершён
+    const int connects = mqtt.connects();
+    started = Clock::now();
+    CHECK(isOk(mqtt.request("embedded/control", warm_restart)));
+    CHECK(isOk(mqtt.request("embedded/control", led_on)));
+    const long restart_us = microsecondsSince(started);
+    CHECK(outputsKept(gpio));
+    CHECK(mqtt.connects() == connects);
+    // Холодный перезапуск занимает секунды
+    CHECK(restart_us < 500000);
+
+    // Брокер разрывает сессию, пока перезапуск ждёт своей итерации: тёплый перезапуск
+    // не должен считать её живой
+    std::atomic<bool> drop_armed{true};
+    mqtt.setPublishHook(
+        [&mqtt, &drop_armed](const std::string &topic, const std::string &, const auto &) {
+            if (topic.rfind("test/reply/", 0) == 0 && drop_armed.exchange(false)) {
+                mqtt.dropSession();
+            }
+        });
+    const auto before_drop = mqtt.publishedCount();
+    CHECK(isOk(mqtt.request("embedded/control", warm_restart)));
+    CHECK(waitForSnapshot(mqtt, before_drop));
+    CHECK(mqtt.connects() == connects + 1);
+    CHECK(mqtt.isConnected());
+    CHECK(outputsKept(gpio));
+
+    // Брокер недоступен: единственная попытка переподключения завершает run()
+    mqtt.setFailConnect(true);
+    mqtt.dropSession();
+    runner.join();
+
+    std::printf("request round trip: %ld us, warm restart and request: %ld us\n",
+                request_us,
+                restart_us);
+    return check::result();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace timeseries {
+
+// Запись битов старшими вперёд в буфер фиксированного размера.
+// Биты перезаписываются целиком, поэтому недописанный хвост можно не очищать.
+class BitWriter
+{
+public:
+    BitWriter(uint8_t *data, std::size_t capacity_bits, std::size_t position)
+        : data_(data)
+        , capacity_(capacity_bits)
+        , position_(position)
+    {}
+
+    // Младшие bits бит value; false, если не помещается (позиция не меняется)
+    bool write(uint64_t value, unsigned bits)
+    {
+        if (position_ + bits > capacity_) {
+            return false;
+        }
+        while (bits > 0) {
+            unsigned offset = position_ % 8;
+            unsigned chunk = bits < 8 - offset ? bits : 8 - offset;
+            auto part = static_cast<uint8_t>((value >> (bits - chunk)) & ((1u << chunk) - 1));
+            unsigned shift = 8 - offset - chunk;
+            auto mask = static_cast<uint8_t>(((1u << chunk) - 1) << shift);
+            uint8_t &byte = data_[position_ / 8];
+            byte = static_cast<uint8_t>((byte & ~mask) | (part << shift));
+            position_ += chunk;
+            bits -= chunk;
+        }
+        return true;
+    }
+
+    std::size_t position() const { return position_; }
+
+private:
+    uint8_t *data_;
+    std::size_t capacity_;
+    std::size_t position_;
+};
+
+class BitReader
+{
+public:
+    BitReader(const uint8_t *data, std::size_t size_bits)
+        : data_(data)
+        , size_(size_bits)
+    {}
+
+    // false, если данных меньше, чем bits
+    bool read(unsigned bits, uint64_t &value)
+    {
+        if (position_ + bits > size_) {
+            return false;
+        }
+        value = 0;
+        while (bits > 0) {
+            unsigned offset = position_ % 8;
+            unsigned chunk = bits < 8 - offset ? bits : 8 - offset;
+            unsigned shift = 8 - offset - chunk;
+            value = (value << chunk) | ((data_[position_ / 8] >> shift) & ((1u << chunk) - 1));
+            position_ += chunk;
+            bits -= chunk;
+        }
+        return true;
+    }
+
+private:
+    const uint8_t *data_;
+    std::size_t size_;
+    std::size_t position_ = 0;
+};
+
+} // namespace timeseries
@@ -0,0 +1,161 @@
+#include "gorilla_codec.hpp"
+#include "bit_stream.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace timeseries {
+
+namespace {
+
+// Диапазоны delta-of-delta: префикс, его длина, число бит значения и смещение
+struct DodBucket
+{
+    uint64_t prefix;
+    unsigned prefix_bits;
+    unsigned value_bits;
+    int64_t bias;
+};
+
+constexpr DodBucket dod_buckets[] = {
+    {0b10, 2, 7, 63},
+    {0b110, 3, 9, 255},
+    {0b1110, 4, 12, 2047},
+};
+
+bool writeTimestamp(BitWriter &writer, int64_t dod)
+{
+    if (dod == 0) {
+        return writer.write(0, 1);
+    }
+    for (const auto &bucket : dod_buckets) {
+        if (dod >= -bucket.bias && dod <= bucket.bias + 1) {
+            return writer.write(bucket.prefix, bucket.prefix_bits)
+                   && writer.write(static_cast<uint64_t>(dod + bucket.bias), bucket.value_bits);
+        }
+    }
+    return writer.write(0b1111, 4) && writer.write(static_cast<uint64_t>(dod), 64);
+}
+
+bool writeValue(BitWriter &writer, EncoderState &state, uint64_t xored)
+{
+    if (xored == 0) {
+        return writer.write(0, 1);
+    }
+
+    auto leading = static_cast<uint8_t>(std::min(std::countl_zero(xored), 31));
+    auto trailing = static_cast<uint8_t>(std::countr_zero(xored));
+
+    if (state.leading != EncoderState::no_window && leading >= state.leading
+        && trailing >= state.trailing) {
+        return writer.write(0b10, 2)
+               && writer.write(xored >> state.trailing, 64 - state.leading - state.trailing);
+    }
+
+    unsigned length = 64 - leading - trailing;
+    state.leading = leading;
+    state.trailing = trailing;
+    return writer.write(0b11, 2) && writer.write(leading, 5) && writer.write(length & 63, 6)
+           && writer.write(xored >> trailing, length);
+}
+
+uint64_t readBits(BitReader &reader, unsigned bits)
+{
+    uint64_t value = 0;
+    if (!reader.read(bits, value)) {
+        throw std::runtime_error("Truncated time-series block");
+    }
+    return value;
+}
+
+int64_t readTimestampDod(BitReader &reader)
+{
+    if (readBits(reader, 1) == 0) {
+        return 0;
+    }
+    for (const auto &bucket : dod_buckets) {
+        if (readBits(reader, 1) == 0) {
+            return static_cast<int64_t>(readBits(reader, bucket.value_bits)) - bucket.bias;
+        }
+    }
+    return static_cast<int64_t>(readBits(reader, 64));
+}
+
+} // namespace
+
+bool appendSample(uint8_t *data, std::size_t capacity, EncoderState &state, const Sample &sample)
+{
+    EncoderState next = state;
+    BitWriter writer(data, capacity * 8, state.bit_length);
+    const auto bits = std::bit_cast<uint64_t>(sample.value);
+
+    bool written = false;
+    if (state.count == 0) {
+        written = writer.write(static_cast<uint64_t>(sample.timestamp_ms), 64)
+                  && writer.write(bits, 64);
+        next.last_delta = 0;
+    } else {
+        // Беззнаковая арифметика: переполнение на произвольных метках времени не UB
+        auto delta = static_cast<int64_t>(static_cast<uint64_t>(sample.timestamp_ms)
+                                          - static_cast<uint64_t>(state.last_timestamp));
+        auto dod = static_cast<int64_t>(static_cast<uint64_t>(delta)
+                                        - static_cast<uint64_t>(state.last_delta));
+        written = writeTimestamp(writer, dod) && writeValue(writer, next, bits ^ state.last_value);
+        next.last_delta = delta;
+    }
+
+    if (!written) {
+        return false;
+    }
+
+    next.last_timestamp = sample.timestamp_ms;
+    next.last_value = bits;
+    next.count = state.count + 1;
+    next.bit_length = static_cast<uint32_t>(writer.position());
+    state = next;
+    return true;
+}
+
+std::vector<Sample> decodeBlock(const uint8_t *data, std::size_t bit_length, uint32_t count)
+{
+    std::vector<Sample> samples;
+    if (count == 0) {
+        return samples;
+    }
+    samples.reserve(count);
+
+    BitReader reader(data, bit_length);
+    auto timestamp = static_cast<int64_t>(readBits(reader, 64));
+    uint64_t value = readBits(reader, 64);
+    samples.push_back({timestamp, std::bit_cast<double>(value)});
+
+    int64_t delta = 0;
+    unsigned leading = 0;
+    unsigned trailing = 0;
+    for (uint32_t i = 1; i < count; ++i) {
+        delta = static_cast<int64_t>(static_cast<uint64_t>(delta)
+                                     + static_cast<uint64_t>(readTimestampDod(reader)));
+        timestamp = static_cast<int64_t>(static_cast<uint64_t>(timestamp)
+                                         + static_cast<uint64_t>(delta));
+
+        if (readBits(reader, 1) == 1) {
+            if (readBits(reader, 1) == 1) {
+                leading = static_cast<unsigned>(readBits(reader, 5));
+                unsigned length = static_cast<unsigned>(readBits(reader, 6));
+                if (length == 0) {
+                    length = 64;
+                }
+                if (leading + length > 64) {
+                    throw std::runtime_error("Corrupted time-series block");
+                }
+                trailing = 64 - leading - length;
+            }
+            value ^= readBits(reader, 64 - leading - trailing) << trailing;
+        }
+        samples.push_back({timestamp, std::bit_cast<double>(value)});
+    }
+    return samples;
+}
+
+} // namespace timeseries
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace timeseries {
+
+struct Sample
+{
+    int64_t timestamp_ms;
+    double value;
+};
+
+// Сжатие в стиле Gorilla (Facebook, VLDB 2015):
+// - первая точка блока пишется как есть: 64 бита времени и 64 бита значения;
+// - время - delta-of-delta: '0' | '10'+7 бит | '110'+9 бит | '1110'+12 бит | '1111'+64 бита;
+// - значение - XOR с предыдущим: '0' - без изменений, '10' - значащие биты в окне
+//   предыдущего значения, '11' + 5 бит ведущих нулей + 6 бит длины (64 -> 0) + значащие биты.
+struct EncoderState
+{
+    uint32_t count = 0;
+    uint32_t bit_length = 0;
+    int64_t last_timestamp = 0;
+    int64_t last_delta = 0;
+    uint64_t last_value = 0;
+    // Окно значащих бит предыдущего XOR, leading == no_window - окна ещё нет
+    uint8_t leading = no_window;
+    uint8_t trailing = 0;
+
+    static constexpr uint8_t no_window = 0xff;
+};
+
+// Дописывает точку в блок data размером capacity байт.
+// false - точка не помещается, блок и state не изменены.
+bool appendSample(uint8_t *data, std::size_t capacity, EncoderState &state, const Sample &sample);
+
+// Разбирает count точек из bit_length бит. Бросает исключение на повреждённом блоке.
+std::vector<Sample> decodeBlock(const uint8_t *data, std::size_t bit_length, uint32_t count);
+
+} // namespace timeseries
@@ -0,0 +1,270 @@
+#include "time_series_store.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace timeseries {
+
+namespace {
+
+constexpr uint64_t file_magic = 0x53455249524f4721; // "!GORIRES"
+constexpr uint32_t file_version = 1;
+
+enum class BlockState : uint32_t {
+    Free = 0,
+    Open = 1,
+    Sealed = 2
+};
+
+} // namespace
+
+// Первый слот файла занимает заголовок, блоки начинаются со второго
+struct Store::FileHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t block_count;
+    uint32_t reserved;
+    // Номер последнего выделенного блока, по нему выбирается самый старый
+    uint64_t generation;
+};
+
+struct Store::BlockHeader
+{
+    SeriesId series;
+    BlockState state;
+    uint64_t generation;
+    int64_t min_ms;
+    int64_t max_ms;
+    // Состояние кодера (EncoderState)
+    uint32_t count;
+    uint32_t bit_length;
+    int64_t last_timestamp;
+    int64_t last_delta;
+    uint64_t last_value;
+    uint8_t leading;
+    uint8_t trailing;
+};
+
+namespace {
+
+constexpr std::size_t payload_offset = 80;
+
+} // namespace
+
+Store::Store(const std::string &path, std::size_t file_size)
+    : path_(path)
+{
+    static_assert(sizeof(BlockHeader) <= payload_offset);
+    static_assert(sizeof(FileHeader) <= block_size);
+
+    if (file_size / block_size < 3) {
+        throw std::runtime_error("Time-series file " + path_ + " is too small");
+    }
+    block_count_ = static_cast<uint32_t>(file_size / block_size - 1);
+    size_ = (block_count_ + 1) * block_size;
+
+    fd_ = open(path_.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("open failed for " + path_ + ": " + std::strerror(errno));
+    }
+
+    struct stat st{};
+    bool resized = fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) != size_;
+    if (resized && ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+        int err = errno;
+        close(fd_);
+        throw std::runtime_error("ftruncate failed for " + path_ + ": " + std::strerror(err));
+    }
+
+    void *addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        int err = errno;
+        close(fd_);
+        throw std::runtime_error("mmap failed for " + path_ + ": " + std::strerror(err));
+    }
+    base_ = static_cast<uint8_t *>(addr);
+
+    initialize();
+}
+
+Store::~Store()
+{
+    if (base_) {
+        msync(base_, size_, MS_ASYNC);
+        munmap(base_, size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void Store::initialize()
+{
+    auto &file = *reinterpret_cast<FileHeader *>(base_);
+    if (file.magic != file_magic || file.version != file_version || file.block_size != block_size
+        || file.block_count != block_count_) {
+        std::memset(base_, 0, size_);
+        file.version = file_version;
+        file.block_size = block_size;
+        file.block_count = block_count_;
+        file.generation = 0;
+        // magic пишется последним: при обрыве инициализации файл будет пересоздан
+        file.magic = file_magic;
+        return;
+    }
+
+    // Восстановление открытых блоков. Если у ряда их оказалось несколько
+    // (обрыв между закрытием и выделением), продолжается самый новый.
+    for (uint32_t index = 0; index < block_count_; ++index) {
+        auto &block = header(index);
+        if (block.state != BlockState::Open) {
+            continue;
+        }
+        auto [it, inserted] = open_blocks_.try_emplace(block.series, index);
+        if (!inserted) {
+            auto &other = header(it->second);
+            if (other.generation < block.generation) {
+                other.state = BlockState::Sealed;
+                it->second = index;
+            } else {
+                block.state = BlockState::Sealed;
+            }
+        }
+    }
+}
+
+Store::BlockHeader &Store::header(uint32_t index) const
+{
+    return *reinterpret_cast<BlockHeader *>(base_ + (index + 1) * block_size);
+}
+
+uint8_t *Store::payload(uint32_t index) const
+{
+    return base_ + (index + 1) * block_size + payload_offset;
+}
+
+uint32_t Store::allocateBlock(SeriesId series)
+{
+    // Свободные блоки имеют нулевой номер и занимаются первыми, затем - самый старый закрытый
+    std::optional<uint32_t> oldest;
+    for (uint32_t index = 0; index < block_count_; ++index) {
+        const auto &block = header(index);
+        if (block.state != BlockState::Open
+            && (!oldest || block.generation < header(*oldest).generation)) {
+            oldest = index;
+        }
+    }
+    if (!oldest) {
+        throw std::runtime_error("Time-series file " + path_ + " has no room for a new series");
+    }
+
+    auto &file = *reinterpret_cast<FileHeader *>(base_);
+    auto &block = header(*oldest);
+    block = BlockHeader{};
+    block.series = series;
+    block.generation = ++file.generation;
+    block.leading = EncoderState::no_window;
+    block.state = BlockState::Open;
+
+    open_blocks_[series] = *oldest;
+    return *oldest;
+}
+
+void Store::append(SeriesId series, int64_t timestamp_ms, double value)
+{
+    static constexpr std::size_t capacity = block_size - payload_offset;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = open_blocks_.find(series);
+    uint32_t index = it != open_blocks_.end() ? it->second : allocateBlock(series);
+
+    auto *block = &header(index);
+    EncoderState state{block->count,
+                       block->bit_length,
+                       block->last_timestamp,
+                       block->last_delta,
+                       block->last_value,
+                       block->leading,
+                       block->trailing};
+
+    if (!appendSample(payload(index), capacity, state, {timestamp_ms, value})) {
+        block->state = BlockState::Sealed;
+        // Закрытый блок больше не меняется, сбрасываем его на диск в фоне
+        auto *page = base_ + (index + 1) * block_size;
+        auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        auto *aligned = base_ + ((page - base_) / page_size) * page_size;
+        msync(aligned, static_cast<std::size_t>(page - aligned) + block_size, MS_ASYNC);
+
+        index = allocateBlock(series);
+        block = &header(index);
+        state = EncoderState{};
+        // В пустой блок первая точка помещается всегда
+        appendSample(payload(index), capacity, state, {timestamp_ms, value});
+    }
+
+    if (state.count == 1) {
+        block->min_ms = timestamp_ms;
+        block->max_ms = timestamp_ms;
+    } else {
+        block->min_ms = std::min(block->min_ms, timestamp_ms);
+        block->max_ms = std::max(block->max_ms, timestamp_ms);
+    }
+    block->last_timestamp = state.last_timestamp;
+    block->last_delta = state.last_delta;
+    block->last_value = state.last_value;
+    block->leading = state.leading;
+    block->trailing = state.trailing;
+    block->bit_length = state.bit_length;
+    // count последним: блок с неполной записью не отдаётся частично
+    block->count = state.count;
+}
+
+std::vector<Store::Block> Store::query(SeriesId series,
+                                       int64_t from_ms,
+                                       int64_t to_ms,
+                                       std::size_t max_blocks) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<uint32_t> matched;
+    for (uint32_t index = 0; index < block_count_; ++index) {
+        const auto &block = header(index);
+        if (block.state != BlockState::Free && block.series == series && block.count > 0
+            && block.min_ms <= to_ms && block.max_ms >= from_ms) {
+            matched.push_back(index);
+        }
+    }
+
+    std::sort(matched.begin(), matched.end(), [this](uint32_t lhs, uint32_t rhs) {
+        return header(lhs).generation < header(rhs).generation;
+    });
+    if (matched.size() > max_blocks) {
+        matched.resize(max_blocks);
+    }
+
+    std::vector<Block> blocks;
+    blocks.reserve(matched.size());
+    for (auto index : matched) {
+        const auto &block = header(index);
+        const uint8_t *data = payload(index);
+        blocks.push_back({block.series,
+                          block.min_ms,
+                          block.max_ms,
+                          block.count,
+                          block.bit_length,
+                          std::vector<uint8_t>(data, data + (block.bit_length + 7) / 8)});
+    }
+    return blocks;
+}
+
+} // namespace timeseries
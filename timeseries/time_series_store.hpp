@@ -0,0 +1,82 @@
+#pragma once
+
+#include "gorilla_codec.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace timeseries {
+
+using SeriesId = uint32_t;
+
+inline constexpr SeriesId temperature_series = 0;
+
+constexpr SeriesId pinSeries(int pin_number)
+{
+    return 0x100 + static_cast<SeriesId>(pin_number);
+}
+
+// Хранилище истории в отображённом в память файле фиксированного размера.
+// Файл - кольцо блоков block_size байт: у каждого ряда один открытый блок, заполненный
+// блок закрывается, а новый занимает место самого старого закрытого. Состояние кодера
+// хранится в заголовке блока, поэтому после перезапуска запись продолжается в тот же блок.
+// Потокобезопасно.
+class Store
+{
+public:
+    static constexpr std::size_t block_size = 1024;
+
+    struct Block
+    {
+        SeriesId series;
+        int64_t start_ms;
+        int64_t end_ms;
+        uint32_t count;
+        uint32_t bit_length;
+        // Сжатые данные, см. gorilla_codec.hpp
+        std::vector<uint8_t> data;
+    };
+
+    // Открывает существующий файл или создаёт новый. Файл другого формата или
+    // размера переинициализируется. Бросает исключение при ошибке ввода-вывода.
+    Store(const std::string &path, std::size_t file_size);
+    ~Store();
+
+    Store(const Store &) = delete;
+    Store &operator=(const Store &) = delete;
+
+    void append(SeriesId series, int64_t timestamp_ms, double value);
+
+    // Блоки ряда, пересекающиеся с [from_ms, to_ms], по возрастанию времени, не больше max_blocks
+    std::vector<Block> query(SeriesId series,
+                             int64_t from_ms,
+                             int64_t to_ms,
+                             std::size_t max_blocks) const;
+
+    std::size_t blockCount() const { return block_count_; }
+
+private:
+    struct FileHeader;
+    struct BlockHeader;
+
+    BlockHeader &header(uint32_t index) const;
+    uint8_t *payload(uint32_t index) const;
+    uint32_t allocateBlock(SeriesId series);
+    void initialize();
+
+    std::string path_;
+    int fd_ = -1;
+    std::size_t size_ = 0;
+    uint8_t *base_ = nullptr;
+    uint32_t block_count_ = 0;
+
+    mutable std::mutex mutex_;
+    // Открытый блок каждого ряда
+    std::unordered_map<SeriesId, uint32_t> open_blocks_;
+};
+
+} // namespace timeseries